@@ -0,0 +1,191 @@
+#include "allocprofiler.h"
+#include <QString>
+#include <QStringList>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+constexpr int kPhaseCount = int(AllocProfiler::Phase::Count);
+
+const char *const kPhaseNames[kPhaseCount] = {
+    "none", "request_build", "parse", "publish", "clock_tick", "lookup"
+};
+
+// Everything here is touched from inside the allocator, so it must be
+// plain atomics: no Qt types and no allocation.
+struct PhaseStats
+{
+    std::atomic<unsigned long long> allocations{0};
+    std::atomic<unsigned long long> bytes{0};
+    std::atomic<unsigned long long> entries{0};
+    std::atomic<unsigned long long> maxPerEntry{0};
+};
+
+PhaseStats g_stats[kPhaseCount];
+thread_local AllocProfiler::Phase t_phase = AllocProfiler::Phase::None;
+
+inline PhaseStats &stats(AllocProfiler::Phase phase)
+{
+    return g_stats[int(phase)];
+}
+
+} // namespace
+
+AllocProfiler::Scope::Scope(Phase phase)
+    : m_phase(phase)
+    , m_previous(t_phase)
+    , m_startCount(stats(phase).allocations.load(std::memory_order_relaxed))
+{
+    t_phase = phase;
+}
+
+AllocProfiler::Scope::~Scope()
+{
+    t_phase = m_previous;
+
+    PhaseStats &s = stats(m_phase);
+    s.entries.fetch_add(1, std::memory_order_relaxed);
+
+    const unsigned long long used = s.allocations.load(std::memory_order_relaxed) - m_startCount;
+    unsigned long long seen = s.maxPerEntry.load(std::memory_order_relaxed);
+    while (used > seen && !s.maxPerEntry.compare_exchange_weak(seen, used, std::memory_order_relaxed)) {
+    }
+}
+
+void AllocProfiler::record(std::size_t bytes)
+{
+    PhaseStats &s = stats(t_phase);
+    s.allocations.fetch_add(1, std::memory_order_relaxed);
+    s.bytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+bool AllocProfiler::reportAndCheckBudget()
+{
+    // Snapshot first: formatting the report allocates too.
+    unsigned long long allocations[kPhaseCount];
+    unsigned long long bytes[kPhaseCount];
+    unsigned long long entries[kPhaseCount];
+    unsigned long long maxPerEntry[kPhaseCount];
+    for (int i = 0; i < kPhaseCount; ++i) {
+        allocations[i] = g_stats[i].allocations.load();
+        bytes[i] = g_stats[i].bytes.load();
+        entries[i] = g_stats[i].entries.load();
+        maxPerEntry[i] = g_stats[i].maxPerEntry.load();
+    }
+
+    std::fprintf(stderr, "%-14s %10s %14s %10s %12s %10s\n",
+                 "phase", "entries", "allocations", "bytes/1k", "allocs/entry", "max/entry");
+    for (int i = 0; i < kPhaseCount; ++i) {
+        const double perEntry = entries[i] ? double(allocations[i]) / double(entries[i]) : 0.0;
+        std::fprintf(stderr, "%-14s %10llu %14llu %10llu %12.1f %10llu\n",
+                     kPhaseNames[i], entries[i], allocations[i], bytes[i] / 1024,
+                     perEntry, maxPerEntry[i]);
+    }
+
+    bool withinBudget = true;
+    const QStringList limits = qEnvironmentVariable("WEATHER_ALLOC_BUDGET")
+                                   .split(QLatin1Char(','), Qt::SkipEmptyParts);
+    for (const QString &limit : limits) {
+        const QString name = limit.section(QLatin1Char('='), 0, 0).trimmed();
+        bool ok = false;
+        const unsigned long long budget = limit.section(QLatin1Char('='), 1).trimmed().toULongLong(&ok);
+
+        int phase = -1;
+        for (int i = 0; i < kPhaseCount; ++i) {
+            if (name == QLatin1String(kPhaseNames[i]))
+                phase = i;
+        }
+        if (phase < 0 || !ok) {
+            std::fprintf(stderr, "alloc budget: ignoring \"%s\"\n", qPrintable(limit));
+            continue;
+        }
+
+        if (maxPerEntry[phase] > budget) {
+            std::fprintf(stderr, "alloc budget: %s made %llu allocations in one entry, budget %llu\n",
+                         kPhaseNames[phase], maxPerEntry[phase], budget);
+            withinBudget = false;
+        }
+    }
+    return withinBudget;
+}
+
+// Qt containers allocate through malloc() rather than operator new, so on
+// glibc the C allocator is interposed as well and operator new only
+// forwards to it. Elsewhere only operator new is counted.
+#if defined(__GLIBC__)
+
+extern "C" {
+void *__libc_malloc(std::size_t size);
+void *__libc_calloc(std::size_t count, std::size_t size);
+void *__libc_realloc(void *ptr, std::size_t size);
+void __libc_free(void *ptr);
+
+void *malloc(std::size_t size)
+{
+    AllocProfiler::record(size);
+    return __libc_malloc(size);
+}
+
+void *calloc(std::size_t count, std::size_t size)
+{
+    AllocProfiler::record(count * size);
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, std::size_t size)
+{
+    AllocProfiler::record(size);
+    return __libc_realloc(ptr, size);
+}
+
+void free(void *ptr)
+{
+    __libc_free(ptr);
+}
+}
+
+#define RECORD_NEW(size) do {} while (false)
+
+#else
+
+#define RECORD_NEW(size) AllocProfiler::record(size)
+
+#endif // __GLIBC__
+
+void *operator new(std::size_t size)
+{
+    RECORD_NEW(size);
+    if (void *p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size)
+{
+    RECORD_NEW(size);
+    if (void *p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+    RECORD_NEW(size);
+    return std::malloc(size ? size : 1);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept
+{
+    RECORD_NEW(size);
+    return std::malloc(size ? size : 1);
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete[](void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete(void *ptr, const std::nothrow_t &) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept { std::free(ptr); }
@@ -0,0 +1,59 @@
+#ifndef ALLOCPROFILER_H
+#define ALLOCPROFILER_H
+
+// Opt-in heap instrumentation, enabled with `qmake CONFIG+=alloc_profile`.
+// The build replaces the global allocator and attributes every allocation
+// to the innermost ALLOC_PHASE() on the current thread. In normal builds
+// ALLOC_PHASE() compiles to nothing.
+
+#ifdef WEATHER_ALLOC_PROFILE
+
+#include <cstddef>
+
+class AllocProfiler
+{
+public:
+    enum class Phase {
+        None,
+        RequestBuild,
+        Parse,
+        Publish,
+        ClockTick,
+        Lookup,
+        Count
+    };
+
+    class Scope
+    {
+    public:
+        explicit Scope(Phase phase);
+        ~Scope();
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+    private:
+        Phase m_phase;
+        Phase m_previous;
+        unsigned long long m_startCount;
+    };
+
+    static void record(std::size_t bytes);
+
+    // Prints per-phase totals to stderr and checks them against
+    // WEATHER_ALLOC_BUDGET ("clock_tick=0,parse=200", allocations per entry).
+    // Returns false when any phase exceeded its budget.
+    static bool reportAndCheckBudget();
+};
+
+#define ALLOC_PHASE_CAT2(a, b) a##b
+#define ALLOC_PHASE_CAT(a, b) ALLOC_PHASE_CAT2(a, b)
+#define ALLOC_PHASE(phase) \
+    AllocProfiler::Scope ALLOC_PHASE_CAT(allocPhase_, __LINE__)(AllocProfiler::Phase::phase)
+
+#else
+
+#define ALLOC_PHASE(phase) do {} while (false)
+
+#endif // WEATHER_ALLOC_PROFILE
+
+#endif // ALLOCPROFILER_H
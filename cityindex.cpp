@@ -0,0 +1,472 @@
+#include "cityindex.h"
+#include "allocprofiler.h"
+#include <QtEndian>
+#include <QDebug>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+constexpr char kMagic[4] = {'W', 'C', 'I', '1'};
+constexpr quint32 kVersion = 1;
+constexpr int kHeaderSize = 32;
+constexpr int kEntrySize = 28;
+
+// Field offsets inside one entry, see tools/build_city_index.py.
+constexpr int kKeyOffset = 0;
+constexpr int kNameOffset = 4;
+constexpr int kPopulation = 8;
+constexpr int kLat = 12;
+constexpr int kLng = 16;
+constexpr int kKeyLen = 20;
+constexpr int kNameLen = 22;
+constexpr int kCountry = 24;
+
+constexpr int kMaxTypoQuery = 32;
+constexpr int kMaxTypoDistance = 2;
+
+inline quint32 readU32(const uchar *p) { return qFromLittleEndian<quint32>(p); }
+inline quint16 readU16(const uchar *p) { return qFromLittleEndian<quint16>(p); }
+
+// Plain byte order, the same order Python sorts bytes objects in.
+int compareKeys(QByteArrayView a, QByteArrayView b)
+{
+    const int common = int(qMin(a.size(), b.size()));
+    const int c = common ? std::memcmp(a.data(), b.data(), size_t(common)) : 0;
+    if (c != 0)
+        return c;
+    return a.size() < b.size() ? -1 : (a.size() > b.size() ? 1 : 0);
+}
+
+inline float readF32(const uchar *p)
+{
+    const quint32 bits = readU32(p);
+    float v;
+    std::memcpy(&v, &bits, sizeof v);
+    return v;
+}
+
+// Letters NFKD leaves alone; must match TRANSLIT in build_city_index.py.
+void appendFolded(QString &out, QChar c)
+{
+    switch (c.unicode()) {
+    case 0x00DF: out += QLatin1String("ss"); break;  // ß
+    case 0x00E6: out += QLatin1String("ae"); break;  // æ
+    case 0x0153: out += QLatin1String("oe"); break;  // œ
+    case 0x00F8: out += QLatin1Char('o'); break;     // ø
+    case 0x0111:                                     // đ
+    case 0x00F0: out += QLatin1Char('d'); break;     // ð
+    case 0x0142: out += QLatin1Char('l'); break;     // ł
+    case 0x0127: out += QLatin1Char('h'); break;     // ħ
+    case 0x0131: out += QLatin1Char('i'); break;     // ı
+    case 0x00FE: out += QLatin1String("th"); break;  // þ
+    default: out += c; break;
+    }
+}
+
+} // namespace
+
+bool CityIndex::load(const QString &path)
+{
+    m_count = 0;
+    m_mostPopulous.clear();
+    m_file.close();
+    m_buffer.clear();
+
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        qWarning() << "City index not found:" << path;
+        return false;
+    }
+
+    // Uncompressed resources and plain files map straight into memory;
+    // anything else falls back to a single read.
+    const qint64 fileSize = m_file.size();
+    const uchar *data = m_file.map(0, fileSize);
+    if (!data) {
+        m_buffer = m_file.readAll();
+        data = reinterpret_cast<const uchar *>(m_buffer.constData());
+    }
+
+    if (fileSize < kHeaderSize || std::memcmp(data, kMagic, sizeof kMagic) != 0
+        || readU32(data + 4) != kVersion) {
+        qWarning() << "Invalid city index:" << path;
+        return false;
+    }
+
+    const quint32 count = readU32(data + 8);
+    const quint32 stringsSize = readU32(data + 12);
+    if (qint64(kHeaderSize) + qint64(count) * kEntrySize + stringsSize != fileSize) {
+        qWarning() << "Truncated city index:" << path;
+        return false;
+    }
+
+    m_entries = data + kHeaderSize;
+    m_strings = reinterpret_cast<const char *>(m_entries + qint64(count) * kEntrySize);
+
+    for (quint32 i = 0; i < count; ++i) {
+        const uchar *e = m_entries + qint64(i) * kEntrySize;
+        if (qint64(readU32(e + kKeyOffset)) + readU16(e + kKeyLen) > stringsSize
+            || qint64(readU32(e + kNameOffset)) + readU16(e + kNameLen) > stringsSize
+            || readU16(e + kKeyLen) == 0) {
+            qWarning() << "Corrupt city index entry" << i << "in" << path;
+            return false;
+        }
+    }
+
+    m_count = int(count);
+
+    // Leaves at [count, 2 * count), each inner node holds the more populous
+    // of its children, so ranking any key range costs O(log n) per result.
+    m_mostPopulous.resize(2 * m_count);
+    for (int i = 0; i < m_count; ++i)
+        m_mostPopulous[m_count + i] = i;
+    for (int i = m_count - 1; i > 0; --i) {
+        const int left = m_mostPopulous[2 * i];
+        const int right = m_mostPopulous[2 * i + 1];
+        m_mostPopulous[i] = morePopulous(left, right) ? left : right;
+    }
+    return true;
+}
+
+QByteArray CityIndex::foldKey(const QString &text)
+{
+    const QString decomposed = text.normalized(QString::NormalizationForm_KD);
+    QString out;
+    out.reserve(decomposed.size());
+
+    bool pendingSpace = false;
+    for (const QChar c : decomposed) {
+        if (c.isMark())
+            continue;
+        if (c.isLetterOrNumber()) {
+            if (pendingSpace && !out.isEmpty())
+                out += QLatin1Char(' ');
+            pendingSpace = false;
+            appendFolded(out, c.toLower());
+        } else {
+            pendingSpace = true;
+        }
+    }
+    return out.toUtf8();
+}
+
+QVector<CityIndex::Match> CityIndex::search(const QString &query, int limit) const
+{
+    ALLOC_PHASE(Lookup);
+    QVector<Match> out;
+    if (!isLoaded() || limit <= 0)
+        return out;
+
+    const QByteArray key = foldKey(query);
+    if (key.isEmpty())
+        return out;
+
+    out.reserve(limit);
+    prefixMatches(key, limit, out);
+    if (out.size() < limit)
+        typoMatches(key, limit, out);
+    return out;
+}
+
+const uchar *CityIndex::entryPtr(int entry) const
+{
+    return m_entries + qint64(entry) * kEntrySize;
+}
+
+QByteArrayView CityIndex::keyAt(int entry) const
+{
+    const uchar *e = entryPtr(entry);
+    return QByteArrayView(m_strings + readU32(e + kKeyOffset), readU16(e + kKeyLen));
+}
+
+int CityIndex::lowerBound(QByteArrayView key) const
+{
+    int lo = 0;
+    int hi = m_count;
+    while (lo < hi) {
+        const int mid = lo + (hi - lo) / 2;
+        if (compareKeys(keyAt(mid), key) < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+bool CityIndex::morePopulous(int a, int b) const
+{
+    const quint32 pa = population(a);
+    const quint32 pb = population(b);
+    return pa != pb ? pa > pb : a < b;
+}
+
+int CityIndex::mostPopulous(int begin, int end) const
+{
+    int best = -1;
+    for (begin += m_count, end += m_count; begin < end; begin >>= 1, end >>= 1) {
+        if (begin & 1) {
+            const int candidate = m_mostPopulous[begin++];
+            if (best < 0 || morePopulous(candidate, best))
+                best = candidate;
+        }
+        if (end & 1) {
+            const int candidate = m_mostPopulous[--end];
+            if (best < 0 || morePopulous(candidate, best))
+                best = candidate;
+        }
+    }
+    return best;
+}
+
+// Appends entries from the given disjoint ranges, most populous first,
+// until out holds limit matches. Each result splits its range in two, so
+// the cost depends on limit, not on how many entries the ranges cover.
+void CityIndex::takeMostPopulous(QVector<EntryRange> ranges, int distance, int limit,
+                                 QVector<Match> &out) const
+{
+    const auto lessPopulous = [this](const EntryRange &a, const EntryRange &b) {
+        return morePopulous(b.top, a.top);
+    };
+    for (EntryRange &range : ranges)
+        range.top = mostPopulous(range.begin, range.end);
+    std::make_heap(ranges.begin(), ranges.end(), lessPopulous);
+
+    while (!ranges.isEmpty() && out.size() < limit) {
+        std::pop_heap(ranges.begin(), ranges.end(), lessPopulous);
+        const EntryRange range = ranges.takeLast();
+        out.append({range.top, distance});
+        for (EntryRange part : {EntryRange{range.begin, range.top, -1},
+                                EntryRange{range.top + 1, range.end, -1}}) {
+            if (part.begin == part.end)
+                continue;
+            part.top = mostPopulous(part.begin, part.end);
+            ranges.append(part);
+            std::push_heap(ranges.begin(), ranges.end(), lessPopulous);
+        }
+    }
+}
+
+void CityIndex::prefixMatches(QByteArrayView key, int limit, QVector<Match> &out) const
+{
+    const int begin = lowerBound(key);
+    int lo = begin;
+    int hi = m_count;
+    while (lo < hi) {
+        const int mid = lo + (hi - lo) / 2;
+        if (keyAt(mid).startsWith(key))
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if (begin < lo)
+        takeMostPopulous({{begin, lo, -1}}, 0, limit, out);
+}
+
+// Depth-first walk over the trie implied by the sorted keys: every node is
+// the entry range sharing one key prefix, and carries the optimal string
+// alignment row of the query against that prefix. A node is dropped as soon
+// as no row cell is within budget, and once the budget is used up only the
+// child bytes that extend a cheapest alignment are looked up, so the cost
+// follows the number of near-miss prefixes rather than the index size.
+struct CityIndex::TypoWalk
+{
+    const CityIndex &index;
+    QByteArrayView query;
+    int maxDist;
+    int wanted;
+    int found[kMaxTypoDistance + 1] = {};
+    QVector<EntryRange> hits[kMaxTypoDistance + 1];
+    int rows[kMaxTypoQuery + kMaxTypoDistance + 1][kMaxTypoQuery + 1];
+    uchar path[kMaxTypoQuery + kMaxTypoDistance + 1];
+
+    TypoWalk(const CityIndex &index, QByteArrayView query, int maxDist, int wanted)
+        : index(index), query(query), maxDist(maxDist), wanted(wanted)
+    {
+        for (int i = 0; i <= query.size(); ++i)
+            rows[0][i] = i;
+    }
+
+    uchar byteAt(int entry, int depth) const { return uchar(index.keyAt(entry)[depth]); }
+
+    void add(int distance, int begin, int end)
+    {
+        hits[distance].append({begin, end, -1});
+        found[distance] += end - begin;
+        // Enough close matches: anything further away can never be shown.
+        int closer = 0;
+        for (int d = 1; d <= distance; ++d)
+            closer += found[d];
+        if (closer >= wanted)
+            maxDist = distance;
+    }
+
+    // First entry in [begin, end) whose byte at depth is not below c.
+    int childBegin(int depth, uchar c, int begin, int end) const
+    {
+        while (begin < end) {
+            const int mid = begin + (end - begin) / 2;
+            if (byteAt(mid, depth) < c)
+                begin = mid + 1;
+            else
+                end = mid;
+        }
+        return begin;
+    }
+
+    // First entry in [begin, end) whose byte at depth is above c. Gallops
+    // first since most children are a handful of entries.
+    int childEnd(int depth, uchar c, int begin, int end) const
+    {
+        int step = 1;
+        while (begin + step < end && byteAt(begin + step - 1, depth) <= c) {
+            begin += step;
+            step *= 2;
+        }
+        end = qMin(end, begin + step);
+        while (begin < end) {
+            const int mid = begin + (end - begin) / 2;
+            if (byteAt(mid, depth) <= c)
+                begin = mid + 1;
+            else
+                end = mid;
+        }
+        return begin;
+    }
+
+    // Entries in [begin, end) share path[0, depth); rows[depth] is their row
+    // and best the smallest distance of the query to any prefix on the way.
+    void walk(int depth, int begin, int end, int best, int rowMin)
+    {
+        int p = begin;
+        while (p < end && index.keyAt(p).size() == depth)
+            ++p;
+        if (p > begin && best <= maxDist)
+            add(best, begin, p);
+
+        const int budget = qMin(best, maxDist + 1);
+        if (rowMin + 1 < budget) {
+            while (p < end) {
+                const uchar c = byteAt(p, depth);
+                const int next = childEnd(depth, c, p + 1, end);
+                visit(depth, c, p, next, best);
+                p = next;
+            }
+            return;
+        }
+
+        // No slack left: a child only stays in budget if its byte matches
+        // the query where the row is cheapest, or completes a transposition.
+        const int m = int(query.size());
+        const int *row = rows[depth];
+        uchar wantedBytes[2 * (2 * kMaxTypoDistance + 1)];
+        int count = 0;
+        const auto want = [&](uchar c) {
+            int k = count++;
+            for (; k > 0 && wantedBytes[k - 1] > c; --k)
+                wantedBytes[k] = wantedBytes[k - 1];
+            wantedBytes[k] = c;
+        };
+        for (int i = qMax(1, depth + 1 - maxDist); i <= qMin(m, depth + 1 + maxDist); ++i) {
+            if (row[i - 1] == rowMin)
+                want(uchar(query[i - 1]));
+            if (i > 1 && depth > 0 && uchar(query[i - 1]) == path[depth - 1]
+                && rows[depth - 1][i - 2] + 1 <= rowMin)
+                want(uchar(query[i - 2]));
+        }
+        count = int(std::unique(wantedBytes, wantedBytes + count) - wantedBytes);
+
+        for (int k = 0; k < count && p < end; ++k) {
+            const int childFirst = childBegin(depth, wantedBytes[k], p, end);
+            const int childLast = childEnd(depth, wantedBytes[k], childFirst, end);
+            if (childFirst > p && best <= maxDist)
+                add(best, p, childFirst);
+            if (childFirst < childLast)
+                visit(depth, wantedBytes[k], childFirst, childLast, best);
+            p = childLast;
+        }
+        if (p < end && best <= maxDist)
+            add(best, p, end);
+    }
+
+    // Extends the alignment by key byte c. Only the band of cells that can
+    // still be within maxDist is computed; its neighbours are capped.
+    void visit(int depth, uchar c, int begin, int end, int best)
+    {
+        const int m = int(query.size());
+        const int j = depth + 1;
+        const int cap = maxDist + 1;
+        const int first = qMax(1, j - maxDist);
+        const int last = qMin(m, j + maxDist);
+        const int *prev = rows[depth];
+        int *cur = rows[j];
+        path[depth] = c;
+
+        cur[0] = j;
+        if (first > 1)
+            cur[first - 1] = cap;
+        if (last < m)
+            cur[last + 1] = cap;
+        int rowMin = first == 1 ? j : cap;
+        for (int i = first; i <= last; ++i) {
+            const int cost = uchar(query[i - 1]) == c ? 0 : 1;
+            int v = qMin(qMin(prev[i] + 1, cur[i - 1] + 1), prev[i - 1] + cost);
+            if (i > 1 && depth > 0 && uchar(query[i - 1]) == path[depth - 1]
+                && uchar(query[i - 2]) == c)
+                v = qMin(v, rows[depth - 1][i - 2] + 1);
+            cur[i] = v;
+            rowMin = qMin(rowMin, v);
+        }
+
+        const int reached = last == m ? qMin(best, cur[m]) : best;
+        if (reached == 0)
+            return;     // the query is a prefix here: reported by prefixMatches
+        if (rowMin >= qMin(reached, cap)) {
+            if (reached <= maxDist)
+                add(reached, begin, end);
+            return;
+        }
+        walk(j, begin, end, reached, rowMin);
+    }
+};
+
+void CityIndex::typoMatches(QByteArrayView key, int limit, QVector<Match> &out) const
+{
+    if (key.size() < 3)
+        return;
+
+    const QByteArrayView query = key.first(qMin<qsizetype>(key.size(), kMaxTypoQuery));
+    const int m = int(query.size());
+    TypoWalk walk(*this, query, m >= 7 ? kMaxTypoDistance : 1, limit - int(out.size()));
+    walk.walk(0, 0, m_count, m, 0);
+
+    for (int d = 1; d <= walk.maxDist && out.size() < limit; ++d)
+        takeMostPopulous(walk.hits[d], d, limit, out);
+}
+
+QString CityIndex::name(int entry) const
+{
+    const uchar *e = entryPtr(entry);
+    return QString::fromUtf8(m_strings + readU32(e + kNameOffset), readU16(e + kNameLen));
+}
+
+QString CityIndex::country(int entry) const
+{
+    const char *code = reinterpret_cast<const char *>(entryPtr(entry) + kCountry);
+    return QString::fromLatin1(code, int(qstrnlen(code, 2)));
+}
+
+double CityIndex::latitude(int entry) const
+{
+    return readF32(entryPtr(entry) + kLat);
+}
+
+double CityIndex::longitude(int entry) const
+{
+    return readF32(entryPtr(entry) + kLng);
+}
+
+quint32 CityIndex::population(int entry) const
+{
+    return readU32(entryPtr(entry) + kPopulation);
+}
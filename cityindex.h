@@ -0,0 +1,65 @@
+#ifndef CITYINDEX_H
+#define CITYINDEX_H
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QFile>
+#include <QString>
+#include <QVector>
+
+// Read-only view over the prebuilt city index produced by
+// tools/build_city_index.py. Entries are sorted by folded key so prefix
+// lookups are a binary search over the mapped file, no parsing at startup.
+class CityIndex
+{
+public:
+    struct Match {
+        int entry;
+        int distance;   // 0 for prefix matches, edit distance otherwise
+    };
+
+    CityIndex() = default;
+    CityIndex(const CityIndex &) = delete;
+    CityIndex &operator=(const CityIndex &) = delete;
+
+    bool load(const QString &path);
+    bool isLoaded() const { return m_count > 0; }
+    int size() const { return m_count; }
+
+    QVector<Match> search(const QString &query, int limit) const;
+
+    QString name(int entry) const;
+    QString country(int entry) const;
+    double latitude(int entry) const;
+    double longitude(int entry) const;
+    quint32 population(int entry) const;
+
+    static QByteArray foldKey(const QString &text);
+
+private:
+    struct EntryRange {
+        int begin;
+        int end;
+        int top;    // most populous entry in [begin, end)
+    };
+    struct TypoWalk;
+
+    const uchar *entryPtr(int entry) const;
+    QByteArrayView keyAt(int entry) const;
+    int lowerBound(QByteArrayView key) const;
+    bool morePopulous(int a, int b) const;
+    int mostPopulous(int begin, int end) const;
+    void takeMostPopulous(QVector<EntryRange> ranges, int distance, int limit,
+                          QVector<Match> &out) const;
+    void prefixMatches(QByteArrayView key, int limit, QVector<Match> &out) const;
+    void typoMatches(QByteArrayView key, int limit, QVector<Match> &out) const;
+
+    QFile m_file;
+    QByteArray m_buffer;        // only used when the file cannot be mapped
+    const uchar *m_entries = nullptr;
+    const char *m_strings = nullptr;
+    int m_count = 0;
+    QVector<int> m_mostPopulous;    // max-population segment tree over entries
+};
+
+#endif // CITYINDEX_H
@@ -0,0 +1,108 @@
+#include "citysearchmodel.h"
+
+CitySearchModel::CitySearchModel(const CityIndex *index, QObject *parent)
+    : QAbstractListModel(parent)
+    , m_index(index)
+{
+}
+
+int CitySearchModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : int(m_matches.size());
+}
+
+QVariant CitySearchModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_matches.size())
+        return QVariant();
+
+    const int entry = m_matches.at(index.row()).entry;
+    switch (role) {
+    case Qt::DisplayRole:
+    case NameRole:
+        return m_index->name(entry);
+    case CountryRole:
+        return m_index->country(entry);
+    case LatitudeRole:
+        return m_index->latitude(entry);
+    case LongitudeRole:
+        return m_index->longitude(entry);
+    case PopulationRole:
+        return m_index->population(entry);
+    default:
+        return QVariant();
+    }
+}
+
+QHash<int, QByteArray> CitySearchModel::roleNames() const
+{
+    return {
+        {NameRole, "name"},
+        {CountryRole, "country"},
+        {LatitudeRole, "lat"},
+        {LongitudeRole, "lng"},
+        {PopulationRole, "population"}
+    };
+}
+
+QString CitySearchModel::query() const
+{
+    return m_query;
+}
+
+void CitySearchModel::setQuery(const QString &query)
+{
+    if (m_query == query)
+        return;
+
+    m_query = query;
+    emit queryChanged();
+    refresh();
+}
+
+int CitySearchModel::limit() const
+{
+    return m_limit;
+}
+
+void CitySearchModel::setLimit(int limit)
+{
+    if (m_limit == limit)
+        return;
+
+    m_limit = limit;
+    emit limitChanged();
+    refresh();
+}
+
+int CitySearchModel::count() const
+{
+    return int(m_matches.size());
+}
+
+QVariantMap CitySearchModel::get(int row) const
+{
+    QVariantMap result;
+    if (row < 0 || row >= m_matches.size())
+        return result;
+
+    const QModelIndex idx = index(row);
+    result["name"] = data(idx, NameRole);
+    result["country"] = data(idx, CountryRole);
+    result["lat"] = data(idx, LatitudeRole);
+    result["lng"] = data(idx, LongitudeRole);
+    result["population"] = data(idx, PopulationRole);
+    return result;
+}
+
+void CitySearchModel::refresh()
+{
+    const int oldCount = count();
+
+    beginResetModel();
+    m_matches = m_index->search(m_query, m_limit);
+    endResetModel();
+
+    if (count() != oldCount)
+        emit countChanged();
+}
@@ -0,0 +1,52 @@
+#ifndef CITYSEARCHMODEL_H
+#define CITYSEARCHMODEL_H
+
+#include <QAbstractListModel>
+#include <QVariantMap>
+#include "cityindex.h"
+
+class CitySearchModel : public QAbstractListModel
+{
+    Q_OBJECT
+    Q_PROPERTY(QString query READ query WRITE setQuery NOTIFY queryChanged)
+    Q_PROPERTY(int limit READ limit WRITE setLimit NOTIFY limitChanged)
+    Q_PROPERTY(int count READ count NOTIFY countChanged)
+
+public:
+    enum Roles {
+        NameRole = Qt::UserRole + 1,
+        CountryRole,
+        LatitudeRole,
+        LongitudeRole,
+        PopulationRole
+    };
+
+    explicit CitySearchModel(const CityIndex *index, QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+    QString query() const;
+    void setQuery(const QString &query);
+    int limit() const;
+    void setLimit(int limit);
+    int count() const;
+
+    Q_INVOKABLE QVariantMap get(int row) const;
+
+signals:
+    void queryChanged();
+    void limitChanged();
+    void countChanged();
+
+private:
+    void refresh();
+
+    const CityIndex *m_index;
+    QString m_query;
+    int m_limit = 10;
+    QVector<CityIndex::Match> m_matches;
+};
+
+#endif // CITYSEARCHMODEL_H
@@ -0,0 +1,46 @@
+#include "clocksource.h"
+#include <QTimer>
+
+namespace {
+
+class SystemTimer : public ClockTimer
+{
+public:
+    explicit SystemTimer(QObject *parent)
+        : ClockTimer(parent)
+        , m_timer(new QTimer(this))
+    {
+        connect(m_timer, &QTimer::timeout, this, &ClockTimer::timeout);
+    }
+
+    void setInterval(int msec) override { m_timer->setInterval(msec); }
+    int interval() const override { return m_timer->interval(); }
+    void start() override { m_timer->start(); }
+    void stop() override { m_timer->stop(); }
+    bool isActive() const override { return m_timer->isActive(); }
+
+private:
+    QTimer *m_timer;
+};
+
+class SystemClock : public ClockSource
+{
+public:
+    QDateTime currentDateTimeUtc() const override
+    {
+        return QDateTime::currentDateTimeUtc();
+    }
+
+    ClockTimer *createTimer(QObject *parent) override
+    {
+        return new SystemTimer(parent);
+    }
+};
+
+} // namespace
+
+ClockSource *ClockSource::system()
+{
+    static SystemClock clock;
+    return &clock;
+}
@@ -0,0 +1,40 @@
+#ifndef CLOCKSOURCE_H
+#define CLOCKSOURCE_H
+
+#include <QObject>
+#include <QDateTime>
+
+// Repeating timer handed out by a ClockSource. The system clock backs it
+// with a QTimer; tests drive it from virtual time instead.
+class ClockTimer : public QObject
+{
+    Q_OBJECT
+
+public:
+    using QObject::QObject;
+
+    virtual void setInterval(int msec) = 0;
+    virtual int interval() const = 0;
+    virtual void start() = 0;
+    virtual void stop() = 0;
+    virtual bool isActive() const = 0;
+
+signals:
+    void timeout();
+};
+
+// Wall clock and timer factory, injectable so long-running behaviour can be
+// exercised in accelerated time.
+class ClockSource
+{
+public:
+    virtual ~ClockSource() = default;
+
+    virtual QDateTime currentDateTimeUtc() const = 0;
+    virtual ClockTimer *createTimer(QObject *parent) = 0;
+
+    // Real time, backed by QDateTime and QTimer.
+    static ClockSource *system();
+};
+
+#endif // CLOCKSOURCE_H
@@ -0,0 +1,241 @@
+#include "framestats.h"
+#include <QDebug>
+#include <QFile>
+#include <QMetaMethod>
+#include <QMutexLocker>
+#include <QQuickWindow>
+#include <QTextStream>
+
+namespace {
+
+inline int summaryIntervalMs() { return 1000; }
+inline int maxFrameHistory() { return 36000; }   // 10 minutes at 60 Hz
+
+inline const QString &defaultDumpPath()
+{
+    static const QString v = qEnvironmentVariable("WEATHER_FRAME_STATS_FILE", QStringLiteral("frame_stats.csv"));
+    return v;
+}
+
+// QObject::receivers() is protected; naming it through a subclass is the
+// standard way to reach it. It includes QML binding subscriptions.
+struct ReceiverCount : QObject
+{
+    static int of(const QObject *object, const QByteArray &signal)
+    {
+        return (object->*(&ReceiverCount::receivers))(signal.constData());
+    }
+};
+
+} // namespace
+
+FrameStats::FrameStats(QObject *parent)
+    : QObject(parent)
+{
+    m_clock.start();
+
+    m_summaryTimer.setInterval(summaryIntervalMs());
+    connect(&m_summaryTimer, &QTimer::timeout, this, &FrameStats::refreshSummary);
+
+    setEnabled(qEnvironmentVariableIntValue("WEATHER_FRAME_STATS") != 0);
+}
+
+FrameStats::~FrameStats()
+{
+    if (!qEnvironmentVariableIsEmpty("WEATHER_FRAME_STATS_FILE"))
+        dump();
+}
+
+void FrameStats::attach(QQuickWindow *window)
+{
+    if (!window)
+        return;
+
+    m_window = window;
+
+    // afterAnimating is emitted on the GUI thread before polish; the
+    // threaded render loop emits the others on the render thread.
+    connect(window, &QQuickWindow::afterAnimating, this,
+            &FrameStats::onAfterAnimating, Qt::DirectConnection);
+    connect(window, &QQuickWindow::beforeSynchronizing, this,
+            &FrameStats::onBeforeSynchronizing, Qt::DirectConnection);
+    connect(window, &QQuickWindow::afterSynchronizing, this,
+            &FrameStats::onAfterSynchronizing, Qt::DirectConnection);
+    connect(window, &QQuickWindow::afterRendering, this,
+            &FrameStats::onAfterRendering, Qt::DirectConnection);
+    connect(window, &QQuickWindow::frameSwapped, this,
+            &FrameStats::onFrameSwapped, Qt::DirectConnection);
+}
+
+void FrameStats::trackSignals(QObject *source, const QString &label)
+{
+    const QMetaObject *meta = source->metaObject();
+    const QMetaMethod slot = metaObject()->method(metaObject()->indexOfSlot("onTrackedSignal()"));
+
+    for (int i = QObject::staticMetaObject.methodCount(); i < meta->methodCount(); ++i) {
+        const QMetaMethod method = meta->method(i);
+        if (method.methodType() != QMetaMethod::Signal)
+            continue;
+
+        SignalStats &stats = m_signals[qMakePair(static_cast<const QObject *>(source), method.methodIndex())];
+        stats.name = label + QLatin1Char('.') + QString::fromLatin1(method.name());
+        connect(source, method, this, slot);
+    }
+}
+
+bool FrameStats::enabled() const
+{
+    return m_enabled;
+}
+
+void FrameStats::setEnabled(bool enabled)
+{
+    if (m_enabled == enabled)
+        return;
+
+    m_enabled = enabled;
+    if (enabled)
+        m_summaryTimer.start();
+    else
+        m_summaryTimer.stop();
+    emit enabledChanged();
+}
+
+QString FrameStats::summary() const
+{
+    return m_summary;
+}
+
+void FrameStats::onTrackedSignal()
+{
+    if (!m_enabled)
+        return;
+
+    const QObject *source = sender();
+    const auto it = m_signals.find(qMakePair(source, senderSignalIndex()));
+    if (it == m_signals.end())
+        return;
+
+    // One of the receivers is this counter.
+    const QByteArray signature = QByteArray::number(QSIGNAL_CODE)
+                                 + source->metaObject()->method(senderSignalIndex()).methodSignature();
+    const int bindings = qMax(0, ReceiverCount::of(source, signature) - 1);
+
+    ++it->emissions;
+    ++it->windowEmissions;
+    it->bindingEvaluations += bindings;
+    it->windowEvaluations += bindings;
+}
+
+void FrameStats::onAfterAnimating()
+{
+    if (m_enabled)
+        m_animatedNs = m_clock.nsecsElapsed();
+}
+
+void FrameStats::onBeforeSynchronizing()
+{
+    if (!m_enabled)
+        return;
+
+    m_syncStartNs = m_clock.nsecsElapsed();
+    m_frameStartNs = m_animatedNs.exchange(0);
+}
+
+void FrameStats::onAfterSynchronizing()
+{
+    if (m_enabled)
+        m_syncEndNs = m_clock.nsecsElapsed();
+}
+
+void FrameStats::onAfterRendering()
+{
+    if (!m_enabled || !m_frameStartNs || !m_syncEndNs)
+        return;
+
+    const qint64 now = m_clock.nsecsElapsed();
+    m_current.cpuMs = (now - m_frameStartNs) / 1e6;
+    m_current.polishMs = (m_syncStartNs - m_frameStartNs) / 1e6;
+    m_current.syncMs = (m_syncEndNs - m_syncStartNs) / 1e6;
+    m_current.renderMs = (now - m_syncEndNs) / 1e6;
+}
+
+void FrameStats::onFrameSwapped()
+{
+    if (!m_enabled)
+        return;
+
+    const qint64 now = m_clock.nsecsElapsed();
+    const double intervalMs = m_lastSwapNs ? (now - m_lastSwapNs) / 1e6 : 0.0;
+    m_lastSwapNs = now;
+
+    m_current.atMs = now / 1000000;
+    m_current.intervalMs = intervalMs;
+
+    QMutexLocker locker(&m_frameMutex);
+    if (m_frames.size() >= maxFrameHistory())
+        m_frames.remove(0, maxFrameHistory() / 2);
+    m_frames.append(m_current);
+
+    ++m_windowFrames;
+    m_windowCpuSum += m_current.cpuMs;
+    m_windowCpuMax = qMax(m_windowCpuMax, m_current.cpuMs);
+    m_windowPolishMax = qMax(m_windowPolishMax, m_current.polishMs);
+    m_windowIntervalMax = qMax(m_windowIntervalMax, intervalMs);
+}
+
+void FrameStats::refreshSummary()
+{
+    QString text;
+    {
+        QMutexLocker locker(&m_frameMutex);
+        const double avg = m_windowFrames ? m_windowCpuSum / m_windowFrames : 0.0;
+        text = QStringLiteral("%1 fps  cpu avg %2 ms  max %3 ms  polish max %4 ms  gap %5 ms")
+                   .arg(m_windowFrames)
+                   .arg(avg, 0, 'f', 1)
+                   .arg(m_windowCpuMax, 0, 'f', 1)
+                   .arg(m_windowPolishMax, 0, 'f', 1)
+                   .arg(m_windowIntervalMax, 0, 'f', 0);
+        m_windowFrames = 0;
+        m_windowCpuSum = 0.0;
+        m_windowCpuMax = 0.0;
+        m_windowPolishMax = 0.0;
+        m_windowIntervalMax = 0.0;
+    }
+
+    for (SignalStats &stats : m_signals) {
+        if (stats.windowEmissions > 0) {
+            text += QStringLiteral("\n%1  x%2  %3 bindings")
+                        .arg(stats.name)
+                        .arg(stats.windowEmissions)
+                        .arg(stats.windowEvaluations);
+        }
+        stats.windowEmissions = 0;
+        stats.windowEvaluations = 0;
+    }
+
+    m_summary = text;
+    emit summaryChanged();
+}
+
+bool FrameStats::dump(const QString &path) const
+{
+    QFile file(path.isEmpty() ? defaultDumpPath() : path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        qWarning() << "Cannot write frame stats to" << file.fileName();
+        return false;
+    }
+
+    QTextStream out(&file);
+    out << "# signal,emissions,binding_evaluations\n";
+    for (const SignalStats &stats : m_signals)
+        out << stats.name << ',' << stats.emissions << ',' << stats.bindingEvaluations << '\n';
+
+    out << "# at_ms,cpu_ms,polish_ms,sync_ms,render_ms,interval_ms\n";
+    QMutexLocker locker(&m_frameMutex);
+    for (const FrameSample &frame : m_frames) {
+        out << frame.atMs << ',' << frame.cpuMs << ',' << frame.polishMs << ','
+            << frame.syncMs << ',' << frame.renderMs << ',' << frame.intervalMs << '\n';
+    }
+    return true;
+}
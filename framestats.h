@@ -0,0 +1,101 @@
+#ifndef FRAMESTATS_H
+#define FRAMESTATS_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QPair>
+#include <QPointer>
+#include <QTimer>
+#include <QVector>
+#include <atomic>
+
+class QQuickWindow;
+
+// Frame timing and binding cost instrumentation. A frame is timed from
+// afterAnimating on the GUI thread, so the polish pass (where binding-driven
+// relayouts land) counts, through sync and render; each stage is also kept
+// separately. Binding cost is estimated per tracked signal as emissions
+// times the QML bindings subscribed at the time of emission.
+class FrameStats : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(bool enabled READ enabled WRITE setEnabled NOTIFY enabledChanged)
+    Q_PROPERTY(QString summary READ summary NOTIFY summaryChanged)
+
+public:
+    explicit FrameStats(QObject *parent = nullptr);
+    ~FrameStats();
+
+    void attach(QQuickWindow *window);
+    void trackSignals(QObject *source, const QString &label);
+
+    bool enabled() const;
+    void setEnabled(bool enabled);
+    QString summary() const;
+
+    Q_INVOKABLE bool dump(const QString &path = QString()) const;
+
+signals:
+    void enabledChanged();
+    void summaryChanged();
+
+private slots:
+    void onTrackedSignal();
+
+private:
+    struct FrameSample {
+        qint64 atMs;
+        double cpuMs;       // afterAnimating to afterRendering
+        double polishMs;    // afterAnimating to beforeSynchronizing
+        double syncMs;      // beforeSynchronizing to afterSynchronizing
+        double renderMs;    // afterSynchronizing to afterRendering
+        double intervalMs;  // since the previous frameSwapped
+    };
+
+    struct SignalStats {
+        QString name;
+        qint64 emissions = 0;
+        qint64 bindingEvaluations = 0;
+        qint64 windowEmissions = 0;
+        qint64 windowEvaluations = 0;
+    };
+
+    void onAfterAnimating();
+    void onBeforeSynchronizing();
+    void onAfterSynchronizing();
+    void onAfterRendering();
+    void onFrameSwapped();
+    void refreshSummary();
+
+    std::atomic<bool> m_enabled{false};
+    QPointer<QQuickWindow> m_window;
+    QElapsedTimer m_clock;
+    QTimer m_summaryTimer;
+    QString m_summary;
+
+    // Set on the GUI thread. The render thread copies it while the GUI
+    // thread is blocked in sync, before the next frame can overwrite it.
+    std::atomic<qint64> m_animatedNs{0};
+
+    // Written from the render thread, read from the GUI thread.
+    mutable QMutex m_frameMutex;
+    QVector<FrameSample> m_frames;
+    qint64 m_frameStartNs = 0;
+    qint64 m_syncStartNs = 0;
+    qint64 m_syncEndNs = 0;
+    qint64 m_lastSwapNs = 0;
+    FrameSample m_current = {};
+
+    // Current one-second summary window.
+    int m_windowFrames = 0;
+    double m_windowCpuSum = 0.0;
+    double m_windowCpuMax = 0.0;
+    double m_windowPolishMax = 0.0;
+    double m_windowIntervalMax = 0.0;
+
+    QHash<QPair<const QObject *, int>, SignalStats> m_signals;
+};
+
+#endif // FRAMESTATS_H
@@ -0,0 +1,159 @@
+#include "geoindex.h"
+#include <QtMath>
+#include <algorithm>
+
+namespace {
+
+constexpr double kEarthRadiusKm = 6371.0088;
+
+void toUnitVector(double lat, double lng, double *v)
+{
+    const double phi = qDegreesToRadians(lat);
+    const double lambda = qDegreesToRadians(lng);
+    v[0] = qCos(phi) * qCos(lambda);
+    v[1] = qCos(phi) * qSin(lambda);
+    v[2] = qSin(phi);
+}
+
+inline double chord2(const double *a, const double *b)
+{
+    const double dx = a[0] - b[0];
+    const double dy = a[1] - b[1];
+    const double dz = a[2] - b[2];
+    return dx * dx + dy * dy + dz * dz;
+}
+
+inline double chord2ToKm(double c2)
+{
+    return 2.0 * qAsin(qMin(1.0, qSqrt(c2) / 2.0)) * kEarthRadiusKm;
+}
+
+QVector<GeoIndex::Hit> toHits(QVector<QPair<double, int>> &pairs)
+{
+    std::sort(pairs.begin(), pairs.end());
+
+    QVector<GeoIndex::Hit> hits;
+    hits.reserve(pairs.size());
+    for (const auto &p : pairs)
+        hits.append({p.second, chord2ToKm(p.first)});
+    return hits;
+}
+
+} // namespace
+
+void GeoIndex::build(const QVector<GeoPoint> &points)
+{
+    m_nodes.clear();
+    m_nodes.reserve(points.size());
+    for (int i = 0; i < points.size(); ++i) {
+        Node node;
+        toUnitVector(points[i].lat, points[i].lng, node.v);
+        node.id = i;
+        m_nodes.append(node);
+    }
+    buildRange(0, int(m_nodes.size()), 0);
+}
+
+void GeoIndex::buildRange(int lo, int hi, int axis)
+{
+    if (hi - lo < 2)
+        return;
+
+    const int mid = lo + (hi - lo) / 2;
+    std::nth_element(m_nodes.begin() + lo, m_nodes.begin() + mid, m_nodes.begin() + hi,
+                     [axis](const Node &a, const Node &b) { return a.v[axis] < b.v[axis]; });
+
+    const int next = (axis + 1) % 3;
+    buildRange(lo, mid, next);
+    buildRange(mid + 1, hi, next);
+}
+
+QVector<GeoIndex::Hit> GeoIndex::nearest(double lat, double lng, int k) const
+{
+    QVector<QPair<double, int>> best;
+    if (k <= 0 || m_nodes.isEmpty())
+        return {};
+
+    double q[3];
+    toUnitVector(lat, lng, q);
+    best.reserve(k);
+    nearestRange(0, int(m_nodes.size()), 0, q, k, best);
+    return toHits(best);
+}
+
+QVector<GeoIndex::Hit> GeoIndex::withinRadius(double lat, double lng, double radiusKm) const
+{
+    QVector<QPair<double, int>> found;
+    if (radiusKm < 0.0 || m_nodes.isEmpty())
+        return {};
+
+    double q[3];
+    toUnitVector(lat, lng, q);
+
+    // Anything at or beyond half the circumference covers the whole sphere.
+    const double angle = radiusKm / kEarthRadiusKm;
+    const double chord = angle >= M_PI ? 2.0 : 2.0 * qSin(angle / 2.0);
+    radiusRange(0, int(m_nodes.size()), 0, q, chord * chord * (1.0 + 1e-12), found);
+    return toHits(found);
+}
+
+double GeoIndex::distanceKm(const GeoPoint &a, const GeoPoint &b)
+{
+    double va[3];
+    double vb[3];
+    toUnitVector(a.lat, a.lng, va);
+    toUnitVector(b.lat, b.lng, vb);
+    return chord2ToKm(chord2(va, vb));
+}
+
+void GeoIndex::nearestRange(int lo, int hi, int axis, const double *q, int k,
+                            QVector<QPair<double, int>> &best) const
+{
+    if (lo >= hi)
+        return;
+
+    const int mid = lo + (hi - lo) / 2;
+    const Node &node = m_nodes[mid];
+    const double d2 = chord2(node.v, q);
+
+    // best is a max-heap on distance holding at most k entries.
+    if (best.size() < k) {
+        best.append({d2, node.id});
+        std::push_heap(best.begin(), best.end());
+    } else if (d2 < best.front().first) {
+        std::pop_heap(best.begin(), best.end());
+        best.last() = {d2, node.id};
+        std::push_heap(best.begin(), best.end());
+    }
+
+    const double diff = q[axis] - node.v[axis];
+    const int next = (axis + 1) % 3;
+    const int nearLo = diff < 0 ? lo : mid + 1;
+    const int nearHi = diff < 0 ? mid : hi;
+    const int farLo = diff < 0 ? mid + 1 : lo;
+    const int farHi = diff < 0 ? hi : mid;
+
+    nearestRange(nearLo, nearHi, next, q, k, best);
+    if (best.size() < k || diff * diff < best.front().first)
+        nearestRange(farLo, farHi, next, q, k, best);
+}
+
+void GeoIndex::radiusRange(int lo, int hi, int axis, const double *q, double maxChord2,
+                           QVector<QPair<double, int>> &out) const
+{
+    if (lo >= hi)
+        return;
+
+    const int mid = lo + (hi - lo) / 2;
+    const Node &node = m_nodes[mid];
+    const double d2 = chord2(node.v, q);
+    if (d2 <= maxChord2)
+        out.append({d2, node.id});
+
+    const double diff = q[axis] - node.v[axis];
+    const int next = (axis + 1) % 3;
+    if (diff < 0 || diff * diff <= maxChord2)
+        radiusRange(lo, mid, next, q, maxChord2, out);
+    if (diff >= 0 || diff * diff <= maxChord2)
+        radiusRange(mid + 1, hi, next, q, maxChord2, out);
+}
@@ -0,0 +1,47 @@
+#ifndef GEOINDEX_H
+#define GEOINDEX_H
+
+#include <QPair>
+#include <QVector>
+
+struct GeoPoint
+{
+    double lat = 0.0;
+    double lng = 0.0;
+};
+
+// Static k-d tree over points on the unit sphere. Points are stored as 3D
+// unit vectors so there is no seam at the antimeridian or the poles, and
+// chord length orders results the same way great-circle distance does.
+class GeoIndex
+{
+public:
+    struct Hit {
+        int id;             // position of the point in build()
+        double distanceKm;
+    };
+
+    void build(const QVector<GeoPoint> &points);
+    int size() const { return int(m_nodes.size()); }
+
+    QVector<Hit> nearest(double lat, double lng, int k) const;
+    QVector<Hit> withinRadius(double lat, double lng, double radiusKm) const;
+
+    static double distanceKm(const GeoPoint &a, const GeoPoint &b);
+
+private:
+    struct Node {
+        double v[3];
+        int id;
+    };
+
+    void buildRange(int lo, int hi, int axis);
+    void nearestRange(int lo, int hi, int axis, const double *q, int k,
+                      QVector<QPair<double, int>> &best) const;
+    void radiusRange(int lo, int hi, int axis, const double *q, double maxChord2,
+                     QVector<QPair<double, int>> &out) const;
+
+    QVector<Node> m_nodes;
+};
+
+#endif // GEOINDEX_H
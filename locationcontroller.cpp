@@ -0,0 +1,135 @@
+#include "locationcontroller.h"
+
+namespace {
+
+inline int defaultTimeoutMs() { return 10 * 1000; }  // 10 seconds
+
+} // namespace
+
+LocationController::LocationController(WeatherBackend *weather, TimeBackend *time,
+                                       ClockSource *clock, QObject *parent)
+    : QObject(parent)
+    , m_weather(weather)
+    , m_time(time)
+    , m_timeout((clock ? clock : ClockSource::system())->createTimer(this))
+{
+    // ClockTimer repeats; publish() stops it, which makes it one-shot.
+    m_timeout->setInterval(defaultTimeoutMs());
+    connect(m_timeout, &ClockTimer::timeout, this, &LocationController::publish);
+}
+
+bool LocationController::loading() const
+{
+    return m_loading;
+}
+
+QString LocationController::locationName() const
+{
+    return m_locationName;
+}
+
+int LocationController::timeoutMs() const
+{
+    return m_timeout->interval();
+}
+
+void LocationController::setTimeoutMs(int msec)
+{
+    m_timeout->setInterval(msec);
+}
+
+void LocationController::selectLocation(const QString &name, double lat, double lng)
+{
+    // A newer selection supersedes any request still in flight.
+    cancelRequests();
+    const quint64 id = ++m_generation;
+    m_pending = Pending();
+    m_pending.id = id;
+    m_pending.name = name;
+    m_pending.lat = lat;
+    m_pending.lng = lng;
+
+    setLoading(true);
+    m_timeout->start();
+
+    const QString query = QStringLiteral("%1,%2").arg(lat, 0, 'f', 4).arg(lng, 0, 'f', 4);
+
+    m_weatherRequest = m_weather->requestWeather(query);
+    m_weatherRequest.then(this, [this, id](WeatherReport report) {
+        if (id != m_generation || !m_loading)
+            return;
+        m_pending.weather = std::move(report);
+        if (m_pending.time)
+            publish();
+    });
+
+    m_timeRequest = m_time->requestTime(lat, lng);
+    m_timeRequest.then(this, [this, id](TimeReport report) {
+        if (id != m_generation || !m_loading)
+            return;
+        m_pending.time = std::move(report);
+        if (m_pending.weather)
+            publish();
+    });
+}
+
+void LocationController::publish()
+{
+    m_timeout->stop();
+    cancelRequests();
+
+    // Called when both parts arrived or on timeout; a missing part timed out.
+    WeatherReport weather = m_pending.weather.value_or(WeatherReport());
+    if (!m_pending.weather)
+        weather.error = QStringLiteral("Weather request timed out");
+
+    TimeReport time = m_pending.time.value_or(TimeReport());
+    if (!m_pending.time)
+        time.error = QStringLiteral("Time request timed out");
+    else if (time.error.isEmpty() && !time.apiTime.isValid())
+        time.error = QStringLiteral("Time data unavailable");
+
+    // Both backends update in the same event loop pass, so QML sees one
+    // consistent change. A part that failed is cleared rather than left
+    // showing the previous location.
+    if (weather.error.isEmpty())
+        m_weather->publishReport(weather);
+    else
+        m_weather->clearWeather();
+
+    // Auto-refresh follows the new selection even when its time failed,
+    // and replies still in flight for the old one are dropped.
+    if (time.error.isEmpty()) {
+        m_time->publishReport(time);
+    } else {
+        m_time->setPosition(m_pending.lat, m_pending.lng);
+        m_time->clearTime();
+    }
+
+    m_locationName = m_pending.name;
+    setLoading(false);
+    emit snapshotReady();
+
+    if (!weather.error.isEmpty())
+        emit errorOccurred(weather.error);
+    if (!time.error.isEmpty())
+        emit errorOccurred(time.error);
+}
+
+void LocationController::cancelRequests()
+{
+    // Aborts the part that has not arrived; finished futures stay as they are.
+    if (!m_weatherRequest.isFinished())
+        m_weatherRequest.cancel();
+    if (!m_timeRequest.isFinished())
+        m_timeRequest.cancel();
+}
+
+void LocationController::setLoading(bool loading)
+{
+    if (m_loading == loading)
+        return;
+
+    m_loading = loading;
+    emit loadingChanged();
+}
@@ -0,0 +1,61 @@
+#ifndef LOCATIONCONTROLLER_H
+#define LOCATIONCONTROLLER_H
+
+#include <QObject>
+#include <optional>
+#include "clocksource.h"
+#include "timebackend.h"
+#include "weatherbackend.h"
+
+// Selects a location by fetching weather and time concurrently and
+// publishing both to the backends in one step, so the UI never pairs the
+// new weather with the previous location's clock.
+class LocationController : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(bool loading READ loading NOTIFY loadingChanged)
+    Q_PROPERTY(QString locationName READ locationName NOTIFY snapshotReady)
+
+public:
+    LocationController(WeatherBackend *weather, TimeBackend *time, ClockSource *clock = nullptr,
+                       QObject *parent = nullptr);
+
+    bool loading() const;
+    QString locationName() const;
+
+    int timeoutMs() const;
+    void setTimeoutMs(int msec);
+
+    Q_INVOKABLE void selectLocation(const QString &name, double lat, double lng);
+
+signals:
+    void snapshotReady();
+    void loadingChanged();
+    void errorOccurred(const QString &message);
+
+private:
+    struct Pending {
+        quint64 id = 0;
+        QString name;
+        double lat = 0.0;
+        double lng = 0.0;
+        std::optional<WeatherReport> weather;
+        std::optional<TimeReport> time;
+    };
+
+    void publish();
+    void cancelRequests();
+    void setLoading(bool loading);
+
+    WeatherBackend *m_weather;
+    TimeBackend *m_time;
+    ClockTimer *m_timeout;
+    quint64 m_generation = 0;
+    Pending m_pending;
+    QFuture<WeatherReport> m_weatherRequest;  // canceled when superseded or timed out
+    QFuture<TimeReport> m_timeRequest;
+    bool m_loading = false;
+    QString m_locationName;
+};
+
+#endif // LOCATIONCONTROLLER_H
@@ -1,22 +1,61 @@
 #include <QGuiApplication>
 #include <QQmlApplicationEngine>
 #include <QQmlContext>
+#include <QQuickWindow>
 #include "weatherbackend.h"
 #include "timebackend.h"
+#include "networkclient.h"
+#include "cityindex.h"
+#include "citysearchmodel.h"
+#include "framestats.h"
+#include "locationcontroller.h"
+#include "allocprofiler.h"
+#include <QTimer>
 
 int main(int argc, char *argv[])
 {
     QGuiApplication app(argc, argv);
 
-    WeatherBackend weatherBackend;
-    TimeBackend timeBackend;
+    // One client for both backends so they share connections and the cache.
+    NetworkClient network;
+    WeatherBackend weatherBackend(&network);
+    TimeBackend timeBackend(&network);
+
+    CityIndex cityIndex;
+    cityIndex.load(qEnvironmentVariable("CITY_INDEX_PATH", QStringLiteral(":/data/cities.bin")));
+    CitySearchModel citySearch(&cityIndex);
+    timeBackend.setCityIndex(&cityIndex);
+    LocationController locationController(&weatherBackend, &timeBackend);
+
+    FrameStats frameStats;
+    frameStats.trackSignals(&weatherBackend, QStringLiteral("weather"));
+    frameStats.trackSignals(&timeBackend, QStringLiteral("time"));
+    frameStats.trackSignals(&locationController, QStringLiteral("location"));
 
     QQmlApplicationEngine engine;
     engine.rootContext()->setContextProperty("weatherBackend", &weatherBackend);
     engine.rootContext()->setContextProperty("timeBackend", &timeBackend);
+    engine.rootContext()->setContextProperty("citySearch", &citySearch);
+    engine.rootContext()->setContextProperty("locationController", &locationController);
+    engine.rootContext()->setContextProperty("network", &network);
+    engine.rootContext()->setContextProperty("frameStats", &frameStats);
 
     const QUrl url(QStringLiteral("qrc:/weatherApp/main.qml"));
     engine.load(url);
+    if (!engine.rootObjects().isEmpty())
+        frameStats.attach(qobject_cast<QQuickWindow *>(engine.rootObjects().first()));
+
+#ifdef WEATHER_ALLOC_PROFILE
+    // Lets CI run the profiling build for a fixed time and gate on the budget.
+    const int profileSeconds = qEnvironmentVariableIntValue("WEATHER_ALLOC_PROFILE_SECONDS");
+    if (profileSeconds > 0)
+        QTimer::singleShot(profileSeconds * 1000, &app, &QCoreApplication::quit);
 
+    const int rc = app.exec();
+    if (!AllocProfiler::reportAndCheckBudget())
+        return rc ? rc : 3;
+    return rc;
+#else
     return app.exec();
+#endif
 }
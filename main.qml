@@ -11,15 +11,30 @@ ApplicationWindow {
 
     property string appLang: "en"
     property var i18n: ({
-        "en": { title: "Weather App", current: "Current Weather", humidity: "Humidity:", wind: "Wind Speed:", btn: "Get Weather", lang: "Language" },
-        "fr": { title: "Application Météo", current: "Météo actuelle", humidity: "Humidité :", wind: "Vitesse du vent :", btn: "Obtenir la météo", lang: "Langue" },
-        "de": { title: "Wetter-App", current: "Aktuelles Wetter", humidity: "Luftfeuchtigkeit:", wind: "Windgeschwindigkeit:", btn: "Wetter abrufen", lang: "Sprache" },
-        "ar": { title: "تطبيق الطقس", current: "الطقس الحالي", humidity: "الرطوبة:", wind: "سرعة الرياح:", btn: "احصل على الطقس", lang: "اللغة" },
-        "es": { title: "Aplicación del tiempo", current: "Tiempo actual", humidity: "Humedad:", wind: "Velocidad del viento:", btn: "Obtener el tiempo", lang: "Idioma" }
+        "en": { title: "Weather App", current: "Current Weather", humidity: "Humidity:", wind: "Wind Speed:", btn: "Get Weather", lang: "Language", search: "Search city" },
+        "fr": { title: "Application Météo", current: "Météo actuelle", humidity: "Humidité :", wind: "Vitesse du vent :", btn: "Obtenir la météo", lang: "Langue", search: "Rechercher une ville" },
+        "de": { title: "Wetter-App", current: "Aktuelles Wetter", humidity: "Luftfeuchtigkeit:", wind: "Windgeschwindigkeit:", btn: "Wetter abrufen", lang: "Sprache", search: "Stadt suchen" },
+        "ar": { title: "تطبيق الطقس", current: "الطقس الحالي", humidity: "الرطوبة:", wind: "سرعة الرياح:", btn: "احصل على الطقس", lang: "اللغة", search: "ابحث عن مدينة" },
+        "es": { title: "Aplicación del tiempo", current: "Tiempo actual", humidity: "Humedad:", wind: "Velocidad del viento:", btn: "Obtener el tiempo", lang: "Idioma", search: "Buscar ciudad" }
     })
 
     function t(k) { return (i18n[appLang] && i18n[appLang][k]) || k }
 
+    property var selectedCity: null
+
+    function selectCity(row) {
+        selectedCity = citySearch.get(row)
+        cityField.text = selectedCity.name
+        cityPopup.close()
+        fetchSelected()
+    }
+
+    function fetchSelected() {
+        if (!selectedCity)
+            return
+        locationController.selectLocation(selectedCity.name, selectedCity.lat, selectedCity.lng)
+    }
+
     Rectangle {
         anchors.fill: parent
         gradient: Gradient {
@@ -60,7 +75,7 @@ ApplicationWindow {
             const entry = langModel.get(index)
             appLang = entry.code
             weatherBackend.setLanguage(entry.code)
-            weatherBackend.fetchWeather(countryCombo.currentText)
+            fetchSelected()
         }
     }
 
@@ -76,28 +91,50 @@ ApplicationWindow {
             color: "white"
         }
 
-        ComboBox {
-            id: countryCombo
+        TextField {
+            id: cityField
             Layout.fillWidth: true
-            model: weatherBackend.countries
-            currentIndex: 0
+            placeholderText: t("search")
             font.pixelSize: 16
 
-            onActivated: {
-                weatherBackend.fetchWeather(currentText)
-                timeBackend.fetchTimeData(currentText)
+            onTextEdited: {
+                citySearch.query = text
+                if (citySearch.count > 0)
+                    cityPopup.open()
+                else
+                    cityPopup.close()
             }
-
-            delegate: ItemDelegate {
-                width: countryCombo.width
-                contentItem: Text {
-                    text: modelData
-                    font: countryCombo.font
-                    color: "black"
-                    verticalAlignment: Text.AlignVCenter
-                    leftPadding: 10
+            onAccepted: if (citySearch.count > 0) selectCity(Math.max(cityList.currentIndex, 0))
+            Keys.onDownPressed: cityList.incrementCurrentIndex()
+            Keys.onUpPressed: cityList.decrementCurrentIndex()
+
+            Popup {
+                id: cityPopup
+                y: cityField.height
+                width: cityField.width
+                height: Math.min(cityList.contentHeight, 300) + topPadding + bottomPadding
+                padding: 0
+
+                ListView {
+                    id: cityList
+                    anchors.fill: parent
+                    clip: true
+                    model: citySearch
+                    currentIndex: 0
+
+                    delegate: ItemDelegate {
+                        width: cityList.width
+                        highlighted: ListView.isCurrentItem
+                        contentItem: Text {
+                            text: country ? name + ", " + country : name
+                            font: cityField.font
+                            color: "black"
+                            verticalAlignment: Text.AlignVCenter
+                            leftPadding: 10
+                        }
+                        onClicked: selectCity(index)
+                    }
                 }
-                background: Rectangle { color: "white" }
             }
         }
 
@@ -160,7 +197,7 @@ ApplicationWindow {
 
                 BusyIndicator {
                     Layout.alignment: Qt.AlignHCenter
-                    running: weatherBackend.loading
+                    running: weatherBackend.loading || locationController.loading
                     visible: running
                 }
             }
@@ -183,7 +220,7 @@ ApplicationWindow {
             Layout.fillWidth: true
             Layout.preferredHeight: 45
             font.pixelSize: 16
-            enabled: !weatherBackend.loading
+            enabled: !weatherBackend.loading && !locationController.loading
 
             background: Rectangle {
                 radius: 5
@@ -198,10 +235,38 @@ ApplicationWindow {
                 verticalAlignment: Text.AlignVCenter
             }
 
-            onClicked: {
-                weatherBackend.fetchWeather(countryCombo.currentText)
-                timeBackend.fetchTimeData(countryCombo.currentText)
-            }
+            onClicked: fetchSelected()
+        }
+    }
+
+    Shortcut {
+        sequence: "F12"
+        onActivated: frameStats.enabled = !frameStats.enabled
+    }
+
+    Shortcut {
+        sequence: "Shift+F12"
+        onActivated: frameStats.dump()
+    }
+
+    Rectangle {
+        anchors.top: parent.top
+        anchors.right: parent.right
+        anchors.margins: 4
+        width: statsText.implicitWidth + 12
+        height: statsText.implicitHeight + 8
+        color: "#B0000000"
+        radius: 4
+        z: 100
+        visible: frameStats.enabled
+
+        Text {
+            id: statsText
+            anchors.centerIn: parent
+            text: frameStats.summary
+            font.family: "monospace"
+            font.pixelSize: 11
+            color: "#00FF66"
         }
     }
 
@@ -215,6 +280,11 @@ ApplicationWindow {
         onErrorOccurred: console.error("Time Error:", message)
     }
 
+    Connections {
+        target: locationController
+        onErrorOccurred: console.error("Location Error:", message)
+    }
+
     Component.onCompleted: {
         timeBackend.startAutoUpdate(300) // Sync every 5 minutes
     }
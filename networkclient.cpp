@@ -0,0 +1,203 @@
+#include "networkclient.h"
+#include "zlibsupport.h"
+#include <QNetworkDiskCache>
+#include <QNetworkRequest>
+#include <QStandardPaths>
+#include <QDebug>
+
+#ifdef WEATHER_BROTLI
+#include <brotli/decode.h>
+#endif
+
+namespace {
+
+inline qint64 httpCacheBytes() { return 5 * 1024 * 1024; }  // 5 MB
+inline qint64 maxDecodedBytes() { return 16 * 1024 * 1024; }
+
+inline const char *bodyProperty() { return "_decodedBody"; }
+inline const char *decodeErrorProperty() { return "_decodeError"; }
+
+// Only codings decodeBody() handles; zstd is not offered.
+inline const QByteArray &acceptEncoding()
+{
+#ifdef WEATHER_BROTLI
+    static const QByteArray v("br, gzip, deflate");
+#else
+    static const QByteArray v("gzip, deflate");
+#endif
+    return v;
+}
+
+// windowBits 15 + 32 accepts both gzip and zlib framing; -15 is raw deflate,
+// which some servers send for "deflate" despite RFC 9110.
+bool inflateBody(const QByteArray &in, int windowBits, QByteArray &out)
+{
+    z_stream zs = {};
+    if (inflateInit2(&zs, windowBits) != Z_OK)
+        return false;
+
+    zs.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(in.constData()));
+    zs.avail_in = uInt(in.size());
+    out.clear();
+
+    char chunk[16 * 1024];
+    int ret = Z_OK;
+    while (ret != Z_STREAM_END && out.size() <= maxDecodedBytes()) {
+        zs.next_out = reinterpret_cast<Bytef *>(chunk);
+        zs.avail_out = uInt(sizeof chunk);
+        ret = inflate(&zs, Z_NO_FLUSH);
+        if (ret != Z_OK && ret != Z_STREAM_END)
+            break;
+        out.append(chunk, qsizetype(sizeof chunk - zs.avail_out));
+    }
+    inflateEnd(&zs);
+    return ret == Z_STREAM_END;
+}
+
+#ifdef WEATHER_BROTLI
+bool unbrotliBody(const QByteArray &in, QByteArray &out)
+{
+    BrotliDecoderState *state = BrotliDecoderCreateInstance(nullptr, nullptr, nullptr);
+    if (!state)
+        return false;
+
+    size_t availIn = size_t(in.size());
+    const uint8_t *nextIn = reinterpret_cast<const uint8_t *>(in.constData());
+    out.clear();
+
+    char chunk[16 * 1024];
+    BrotliDecoderResult ret = BROTLI_DECODER_RESULT_NEEDS_MORE_OUTPUT;
+    while (ret == BROTLI_DECODER_RESULT_NEEDS_MORE_OUTPUT && out.size() <= maxDecodedBytes()) {
+        size_t availOut = sizeof chunk;
+        uint8_t *nextOut = reinterpret_cast<uint8_t *>(chunk);
+        ret = BrotliDecoderDecompressStream(state, &availIn, &nextIn, &availOut, &nextOut, nullptr);
+        out.append(chunk, qsizetype(sizeof chunk - availOut));
+    }
+    BrotliDecoderDestroyInstance(state);
+    return ret == BROTLI_DECODER_RESULT_SUCCESS;
+}
+#endif
+
+// False for a corrupt body and for any coding not in acceptEncoding().
+bool decodeBody(const QByteArray &raw, const QByteArray &coding, QByteArray &out)
+{
+    if (coding.isEmpty() || coding == "identity") {
+        out = raw;
+        return true;
+    }
+    if (coding == "gzip" || coding == "x-gzip")
+        return inflateBody(raw, 15 + 32, out);
+    if (coding == "deflate")
+        return inflateBody(raw, 15 + 32, out) || inflateBody(raw, -15, out);
+#ifdef WEATHER_BROTLI
+    if (coding == "br")
+        return unbrotliBody(raw, out);
+#endif
+    return false;
+}
+
+} // namespace
+
+NetworkClient::NetworkClient(QObject *parent)
+    : QObject(parent)
+    , m_manager(new QNetworkAccessManager(this))
+{
+    // With a cache attached, QNetworkAccessManager serves fresh entries per
+    // Cache-Control/Expires and revalidates stale ones with
+    // If-None-Match/If-Modified-Since, turning a 304 into the cached body.
+    const QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    if (!cacheDir.isEmpty()) {
+        auto *cache = new QNetworkDiskCache(this);
+        cache->setCacheDirectory(cacheDir + QStringLiteral("/http"));
+        cache->setMaximumCacheSize(httpCacheBytes());
+        m_manager->setCache(cache);
+    }
+}
+
+QNetworkReply *NetworkClient::get(const QUrl &url)
+{
+    QNetworkRequest request(url);
+
+    // Setting Accept-Encoding by hand turns off Qt's transparent
+    // decompression. Qt would otherwise strip Content-Length and report
+    // decoded sizes everywhere, leaving no way to see the compressed size.
+    // recordTransfer() decodes the body itself instead.
+    request.setRawHeader("Accept-Encoding", acceptEncoding());
+    request.setAttribute(QNetworkRequest::Http2AllowedAttribute, true);
+    request.setAttribute(QNetworkRequest::CacheLoadControlAttribute,
+                         QNetworkRequest::PreferNetwork);
+    request.setAttribute(QNetworkRequest::CacheSaveControlAttribute, true);
+
+    QNetworkReply *reply = m_manager->get(request);
+    ++m_requestCount;
+
+    // Connected before any caller gets the reply, so the body is decoded
+    // before the caller's finished handler asks for it.
+    connect(reply, &QNetworkReply::finished, this, [this, reply]() {
+        recordTransfer(reply);
+    });
+    return reply;
+}
+
+QByteArray NetworkClient::body(const QNetworkReply *reply)
+{
+    return reply->property(bodyProperty()).toByteArray();
+}
+
+QString NetworkClient::errorString(const QNetworkReply *reply)
+{
+    if (reply->error() != QNetworkReply::NoError)
+        return reply->errorString();
+    return reply->property(decodeErrorProperty()).toString();
+}
+
+void NetworkClient::recordTransfer(QNetworkReply *reply)
+{
+    // The cache stores the body as it came off the wire, so hits are
+    // decoded the same way as fresh responses.
+    const QByteArray raw = reply->readAll();
+    const QByteArray coding = reply->rawHeader("Content-Encoding").trimmed().toLower();
+
+    QByteArray decoded;
+    if (!decodeBody(raw, coding, decoded)) {
+        qWarning() << "Cannot decode" << coding << "body from" << reply->url().host();
+        decoded.clear();
+        reply->setProperty(decodeErrorProperty(),
+                           QStringLiteral("Cannot decode %1 response body")
+                               .arg(QString::fromLatin1(coding)));
+        ++m_decodeErrors;
+    }
+    reply->setProperty(bodyProperty(), decoded);
+
+    if (reply->attribute(QNetworkRequest::SourceIsFromCacheAttribute).toBool())
+        ++m_cacheHits;   // fresh hit or 304 revalidation, no body on the wire
+    else
+        m_bytesOnWire += raw.size();
+    m_bytesDecoded += decoded.size();
+    emit statsChanged();
+}
+
+qint64 NetworkClient::bytesOnWire() const
+{
+    return m_bytesOnWire;
+}
+
+qint64 NetworkClient::bytesDecoded() const
+{
+    return m_bytesDecoded;
+}
+
+int NetworkClient::requestCount() const
+{
+    return m_requestCount;
+}
+
+int NetworkClient::cacheHits() const
+{
+    return m_cacheHits;
+}
+
+int NetworkClient::decodeErrors() const
+{
+    return m_decodeErrors;
+}
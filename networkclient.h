@@ -0,0 +1,54 @@
+#ifndef NETWORKCLIENT_H
+#define NETWORKCLIENT_H
+
+#include <QObject>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QUrl>
+
+// Single HTTP entry point shared by the backends, so requests to the same
+// host reuse one HTTP/2 connection and one revalidating disk cache.
+class NetworkClient : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(qint64 bytesOnWire READ bytesOnWire NOTIFY statsChanged)
+    Q_PROPERTY(qint64 bytesDecoded READ bytesDecoded NOTIFY statsChanged)
+    Q_PROPERTY(int requestCount READ requestCount NOTIFY statsChanged)
+    Q_PROPERTY(int cacheHits READ cacheHits NOTIFY statsChanged)
+    Q_PROPERTY(int decodeErrors READ decodeErrors NOTIFY statsChanged)
+
+public:
+    explicit NetworkClient(QObject *parent = nullptr);
+
+    QNetworkReply *get(const QUrl &url);
+
+    // Decoded response body of a finished reply from get(). Use this
+    // instead of readAll(): the client has already consumed the raw bytes.
+    static QByteArray body(const QNetworkReply *reply);
+
+    // Why a finished reply from get() has no usable body: the network
+    // error, or a Content-Encoding the client could not decode. Empty when
+    // body() holds the response.
+    static QString errorString(const QNetworkReply *reply);
+
+    qint64 bytesOnWire() const;
+    qint64 bytesDecoded() const;
+    int requestCount() const;
+    int cacheHits() const;
+    int decodeErrors() const;
+
+signals:
+    void statsChanged();
+
+private:
+    void recordTransfer(QNetworkReply *reply);
+
+    QNetworkAccessManager *m_manager;
+    qint64 m_bytesOnWire = 0;
+    qint64 m_bytesDecoded = 0;
+    int m_requestCount = 0;
+    int m_cacheHits = 0;
+    int m_decodeErrors = 0;
+};
+
+#endif // NETWORKCLIENT_H
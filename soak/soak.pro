@@ -0,0 +1,31 @@
+# Virtual-clock soak harness: qmake soak/soak.pro && make && ./weathersoak --days 28
+QT = core network
+CONFIG += console
+CONFIG -= app_bundle
+
+TARGET = weathersoak
+INCLUDEPATH += ..
+
+SOURCES += \
+        soakmain.cpp \
+        standinserver.cpp \
+        virtualclock.cpp \
+        ../cityindex.cpp \
+        ../clocksource.cpp \
+        ../geoindex.cpp \
+        ../networkclient.cpp \
+        ../timebackend.cpp \
+        ../weatherbackend.cpp
+
+HEADERS += \
+    standinserver.h \
+    virtualclock.h \
+    ../allocprofiler.h \
+    ../cityindex.h \
+    ../clocksource.h \
+    ../geoindex.h \
+    ../networkclient.h \
+    ../timebackend.h \
+    ../weatherbackend.h
+
+include(../zlib.pri)
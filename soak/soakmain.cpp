@@ -0,0 +1,225 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QEventLoop>
+#include <QTimeZone>
+#include <QTimer>
+#include <cstdio>
+#include "networkclient.h"
+#include "standinserver.h"
+#include "timebackend.h"
+#include "virtualclock.h"
+#include "weatherbackend.h"
+
+#ifdef Q_OS_LINUX
+#include <unistd.h>
+#endif
+
+// Runs TimeBackend and WeatherBackend for weeks of virtual time against a
+// local stand-in for both upstream APIs and reports timer wakeups, resident
+// memory growth and displayed-time drift.
+
+namespace {
+
+constexpr qint64 kSecondMs = 1000;
+constexpr qint64 kHourMs = 60 * 60 * kSecondMs;
+constexpr qint64 kDayMs = 24 * kHourMs;
+constexpr int kRefreshSeconds = 300;   // matches main.qml
+
+// Real time a request to the local stand-in may take before the run fails.
+constexpr int kSettleTimeoutMs = 10 * 1000;
+
+// Drift is sampled half way between two local-time ticks. Sampling right
+// after a tick would always read back exactly what that tick formatted, so
+// with --jitter-ms 0 the drift would be zero by construction.
+constexpr qint64 kSampleOffsetMs = kSecondMs / 2;
+
+qint64 residentKb()
+{
+#ifdef Q_OS_LINUX
+    FILE *statm = std::fopen("/proc/self/statm", "r");
+    if (!statm)
+        return -1;
+    long pages = 0;
+    long resident = 0;
+    const int read = std::fscanf(statm, "%ld %ld", &pages, &resident);
+    std::fclose(statm);
+    return read == 2 ? qint64(resident) * sysconf(_SC_PAGESIZE) / 1024 : -1;
+#else
+    return -1;
+#endif
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Virtual-clock soak test for the weather backends"));
+    parser.addHelpOption();
+    const QCommandLineOption daysOpt(QStringLiteral("days"), QStringLiteral("Virtual days to simulate."),
+                                     QStringLiteral("days"), QStringLiteral("14"));
+    const QCommandLineOption jitterOpt(QStringLiteral("jitter-ms"), QStringLiteral("Max timer lateness per firing."),
+                                       QStringLiteral("ms"), QStringLiteral("0"));
+    const QCommandLineOption offsetOpt(QStringLiteral("gmt-offset"), QStringLiteral("Offset served by the stand-in, in seconds."),
+                                       QStringLiteral("sec"), QStringLiteral("3600"));
+    const QCommandLineOption maxRssOpt(QStringLiteral("max-rss-growth-kb"), QStringLiteral("Fail above this growth."),
+                                       QStringLiteral("kb"), QStringLiteral("-1"));
+    const QCommandLineOption maxDriftOpt(QStringLiteral("max-drift-s"), QStringLiteral("Fail above this drift."),
+                                         QStringLiteral("sec"), QStringLiteral("-1"));
+    parser.addOptions({daysOpt, jitterOpt, offsetOpt, maxRssOpt, maxDriftOpt});
+    parser.process(app);
+
+    const int days = qMax(1, parser.value(daysOpt).toInt());
+    const int gmtOffset = parser.value(offsetOpt).toInt();
+
+    VirtualClock clock(QDateTime(QDate(2025, 1, 1), QTime(0, 0), QTimeZone::UTC));
+    clock.setJitter(parser.value(jitterOpt).toInt());
+
+    StandInServer server(&clock, gmtOffset);
+    if (!server.listenLocal()) {
+        std::fprintf(stderr, "soak: cannot listen on localhost\n");
+        return 2;
+    }
+    // Read once by the backends' URL helpers, so set before first use.
+    qputenv("WEATHER_API_BASE", server.weatherUrl().toString().toUtf8());
+    qputenv("TIME_API_BASE", server.timeUrl().toString().toUtf8());
+
+    NetworkClient network;
+    int completed = 0;
+    QObject::connect(&network, &NetworkClient::statsChanged, [&completed]() { ++completed; });
+
+    int weatherErrors = 0;
+    int timeErrors = 0;
+    WeatherBackend weatherBackend(&network);
+    TimeBackend timeBackend(&network, &clock);
+    QObject::connect(&weatherBackend, &WeatherBackend::errorOccurred, [&weatherErrors]() { ++weatherErrors; });
+    QObject::connect(&timeBackend, &TimeBackend::errorOccurred, [&timeErrors]() { ++timeErrors; });
+
+    // Lets every in-flight request finish and frees finished replies, so
+    // virtual time never runs ahead of the network. Sleeps in an event loop
+    // until the last reply is counted or the real-time deadline passes;
+    // returns false on the deadline.
+    QEventLoop settleLoop;
+    QTimer settleDeadline;
+    settleDeadline.setSingleShot(true);
+    settleDeadline.setInterval(kSettleTimeoutMs);
+    QObject::connect(&settleDeadline, &QTimer::timeout, &settleLoop, &QEventLoop::quit);
+    QObject::connect(&network, &NetworkClient::statsChanged, &settleLoop, [&]() {
+        if (completed >= network.requestCount())
+            settleLoop.quit();
+    });
+    const auto settle = [&]() {
+        if (completed < network.requestCount()) {
+            settleDeadline.start();
+            settleLoop.exec();
+            settleDeadline.stop();
+        }
+        QCoreApplication::processEvents();
+        QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+        return completed >= network.requestCount();
+    };
+
+    const double lat = 48.8566;
+    const double lng = 2.3522;
+    const QString location = QStringLiteral("%1,%2").arg(lat).arg(lng);
+    weatherBackend.fetchWeather(location);
+    timeBackend.fetchTimeDataAt(lat, lng);
+    timeBackend.startAutoUpdate(kRefreshSeconds);
+    bool settled = settle();
+
+    qint64 rssStart = -1;
+    qint64 wakeupsStart = 0;
+    qint64 maxDriftSec = 0;
+    int driftSamples = 0;
+    int unreadableSamples = 0;
+    const qint64 totalMs = days * kDayMs;
+
+    while (settled && clock.elapsedMs() < totalMs) {
+        clock.advance(kSecondMs);
+        if (clock.elapsedMs() % (kRefreshSeconds * kSecondMs) == 0)
+            weatherBackend.fetchWeather(location);
+        if (!(settled = settle()))
+            break;
+
+        if (clock.elapsedMs() % kHourMs != 0)
+            continue;
+
+        // The first virtual hour is warm-up: caches, connections, pools.
+        if (clock.elapsedMs() == kHourMs) {
+            rssStart = residentKb();
+            wakeupsStart = clock.wakeups();
+        }
+
+        clock.advance(kSampleOffsetMs);
+        if (!(settled = settle()))
+            break;
+
+        // "--:--" or any other unparseable string is a failure, not zero
+        // drift: msecsTo() on an invalid QDateTime returns 0.
+        QDateTime shown = QDateTime::fromString(timeBackend.timeString(),
+                                                QStringLiteral("dd/MM/yyyy hh:mm:ss"));
+        ++driftSamples;
+        if (shown.isValid()) {
+            shown.setTimeZone(QTimeZone::UTC);
+            const QDateTime expected = clock.currentDateTimeUtc().addSecs(gmtOffset);
+            maxDriftSec = qMax(maxDriftSec, qAbs(shown.msecsTo(expected)) / kSecondMs);
+        } else {
+            ++unreadableSamples;
+        }
+
+        clock.advance(kSecondMs - kSampleOffsetMs);
+        settled = settle();
+    }
+
+    const qint64 rssEnd = residentKb();
+    const double measuredHours = double(totalMs - kHourMs) / kHourMs;
+    const double wakeupsPerHour = (clock.wakeups() - wakeupsStart) / measuredHours;
+    const qint64 rssGrowth = rssStart >= 0 && rssEnd >= 0 ? rssEnd - rssStart : -1;
+
+    std::printf("virtual time      %d d\n", days);
+    std::printf("wakeups/hour      %.1f\n", wakeupsPerHour);
+    std::printf("requests          %d sent, %d served, %d weather errors, %d time errors\n",
+                network.requestCount(), server.requestsServed(), weatherErrors, timeErrors);
+    std::printf("response bodies   %lld B on wire, %lld B decoded, %d gzip, %d undecodable\n",
+                (long long)network.bytesOnWire(), (long long)network.bytesDecoded(), server.gzipServed(),
+                network.decodeErrors());
+    std::printf("resident memory   start %lld KB, end %lld KB, growth %lld KB (%.1f KB/day)\n",
+                (long long)rssStart, (long long)rssEnd, (long long)rssGrowth, rssGrowth >= 0 ? double(rssGrowth) / days : 0.0);
+    std::printf("offset drift      max %lld s over %d mid-tick samples, %d unreadable\n",
+                (long long)maxDriftSec, driftSamples, unreadableSamples);
+
+    bool ok = true;
+    if (!settled) {
+        std::printf("FAIL: %d requests still open %d s after virtual %s\n",
+                    network.requestCount() - completed, kSettleTimeoutMs / 1000,
+                    qPrintable(clock.currentDateTimeUtc().toString(Qt::ISODate)));
+        ok = false;
+    }
+    if (weatherErrors > 0 || timeErrors > 0) {
+        std::printf("FAIL: %d weather and %d time requests failed\n", weatherErrors, timeErrors);
+        ok = false;
+    }
+    if (unreadableSamples > 0) {
+        std::printf("FAIL: displayed time was unreadable in %d of %d samples\n",
+                    unreadableSamples, driftSamples);
+        ok = false;
+    }
+    if (server.gzipServed() == 0 || network.decodeErrors() > 0
+        || network.bytesOnWire() >= network.bytesDecoded()) {
+        std::printf("FAIL: gzip responses were not decoded or not counted compressed\n");
+        ok = false;
+    }
+    const qint64 maxRss = parser.value(maxRssOpt).toLongLong();
+    if (maxRss >= 0 && rssGrowth > maxRss) {
+        std::printf("FAIL: resident memory grew %lld KB, limit %lld KB\n", (long long)rssGrowth, (long long)maxRss);
+        ok = false;
+    }
+    const qint64 maxDrift = parser.value(maxDriftOpt).toLongLong();
+    if (maxDrift >= 0 && maxDriftSec > maxDrift) {
+        std::printf("FAIL: displayed time drifted %lld s, limit %lld s\n", (long long)maxDriftSec, (long long)maxDrift);
+        ok = false;
+    }
+    return ok ? 0 : 1;
+}
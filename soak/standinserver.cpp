@@ -0,0 +1,189 @@
+#include "standinserver.h"
+#include "clocksource.h"
+#include "zlibsupport.h"
+#include <QHostAddress>
+#include <QTcpSocket>
+#include <utility>
+
+namespace {
+
+// Shaped like a full WeatherAPI current.json reply, so gzip has something
+// to save and the soak run exercises the client's decoding path.
+const char *weatherPayload()
+{
+    return R"({"location":{"name":"Stand-in","region":"Ile-de-France","country":"France",)"
+           R"("lat":48.8566,"lon":2.3522,"tz_id":"Europe/Paris","localtime_epoch":1735689600,)"
+           R"("localtime":"2025-01-01 01:00"},)"
+           R"("current":{"last_updated_epoch":1735689600,"last_updated":"2025-01-01 01:00",)"
+           R"("temp_c":21.5,"temp_f":70.7,"is_day":1,)"
+           R"("condition":{"text":"Sunny","icon":"//cdn.weatherapi.com/weather/64x64/day/113.png","code":1000},)"
+           R"("wind_mph":7.5,"wind_kph":12.0,"wind_degree":250,"wind_dir":"WSW",)"
+           R"("pressure_mb":1016.0,"pressure_in":30.0,"precip_mm":0.0,"precip_in":0.0,)"
+           R"("humidity":40,"cloud":0,"feelslike_c":21.5,"feelslike_f":70.7,)"
+           R"("windchill_c":21.5,"windchill_f":70.7,"heatindex_c":21.5,"heatindex_f":70.7,)"
+           R"("dewpoint_c":7.5,"dewpoint_f":45.5,"vis_km":10.0,"vis_miles":6.0,)"
+           R"("uv":4.0,"gust_mph":9.8,"gust_kph":15.8}})";
+}
+
+QByteArray gzip(const QByteArray &data)
+{
+    z_stream zs = {};
+    if (deflateInit2(&zs, Z_BEST_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        return QByteArray();
+
+    QByteArray out(qsizetype(deflateBound(&zs, uLong(data.size()))), Qt::Uninitialized);
+    zs.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.constData()));
+    zs.avail_in = uInt(data.size());
+    zs.next_out = reinterpret_cast<Bytef *>(out.data());
+    zs.avail_out = uInt(out.size());
+    const int ret = deflate(&zs, Z_FINISH);
+    out.resize(qsizetype(zs.total_out));
+    deflateEnd(&zs);
+    return ret == Z_STREAM_END ? out : QByteArray();
+}
+
+bool acceptsGzip(const QByteArray &request)
+{
+    const QList<QByteArray> lines = request.left(request.indexOf("\r\n\r\n")).split('\n');
+    for (const QByteArray &line : lines) {
+        const QByteArray header = line.toLower();
+        if (header.startsWith("accept-encoding:") && header.contains("gzip"))
+            return true;
+    }
+    return false;
+}
+
+} // namespace
+
+StandInServer::StandInServer(const ClockSource *clock, int gmtOffsetSec, QObject *parent)
+    : QTcpServer(parent)
+    , m_clock(clock)
+    , m_gmtOffsetSec(gmtOffsetSec)
+{
+    connect(this, &QTcpServer::newConnection, this, &StandInServer::onNewConnection);
+}
+
+bool StandInServer::listenLocal()
+{
+    return listen(QHostAddress::LocalHost, 0);
+}
+
+QUrl StandInServer::weatherUrl() const
+{
+    return QUrl(QStringLiteral("http://127.0.0.1:%1/weather").arg(serverPort()));
+}
+
+QUrl StandInServer::timeUrl() const
+{
+    return QUrl(QStringLiteral("http://127.0.0.1:%1/time").arg(serverPort()));
+}
+
+int StandInServer::requestsServed() const
+{
+    return m_requestsServed;
+}
+
+int StandInServer::gzipServed() const
+{
+    return m_gzipServed;
+}
+
+void StandInServer::setHeld(const QByteArray &path, bool held)
+{
+    m_heldPaths.removeAll(path);
+    if (held)
+        m_heldPaths.append(path);
+}
+
+// Answers every held request whose client is still connected. Returns how
+// many were answered.
+int StandInServer::releaseHeld()
+{
+    const QList<QTcpSocket *> held = std::exchange(m_held, {});
+    for (QTcpSocket *socket : held)
+        respond(socket, socket->property("request").toByteArray());
+    return int(held.size());
+}
+
+int StandInServer::heldCount() const
+{
+    return int(m_held.size());
+}
+
+int StandInServer::abortedHeld() const
+{
+    return m_abortedHeld;
+}
+
+void StandInServer::onNewConnection()
+{
+    while (QTcpSocket *socket = nextPendingConnection()) {
+        connect(socket, &QTcpSocket::readyRead, this, [this, socket]() { onReadyRead(socket); });
+        connect(socket, &QTcpSocket::disconnected, this, [this, socket]() {
+            if (m_held.removeOne(socket))
+                ++m_abortedHeld;
+        });
+        connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+    }
+}
+
+void StandInServer::onReadyRead(QTcpSocket *socket)
+{
+    QByteArray request = socket->property("request").toByteArray() + socket->readAll();
+    socket->setProperty("request", request);
+    if (!request.contains("\r\n\r\n"))
+        return;
+
+    const QByteArray path = request.split(' ').value(1);
+    for (const QByteArray &held : std::as_const(m_heldPaths)) {
+        if (path.startsWith(held)) {
+            m_held.append(socket);
+            return;
+        }
+    }
+    respond(socket, request);
+}
+
+void StandInServer::respond(QTcpSocket *socket, const QByteArray &request)
+{
+    const QByteArray path = request.split(' ').value(1);
+    QByteArray status = "200 OK";
+    QByteArray encoding;
+    QByteArray body;
+    if (path.startsWith("/time")) {
+        body = timePayload();
+    } else if (path.startsWith("/weather")) {
+        // Only the weather reply is compressed, so both the identity and
+        // the gzip decoding paths run on every refresh.
+        body = weatherPayload();
+        if (acceptsGzip(request)) {
+            body = gzip(body);
+            encoding = "Content-Encoding: gzip\r\n";
+            ++m_gzipServed;
+        }
+    } else {
+        status = "404 Not Found";
+        body = "{}";
+    }
+
+    socket->write("HTTP/1.1 " + status + "\r\n"
+                  "Content-Type: application/json\r\n"
+                  + encoding +
+                  "Cache-Control: no-store\r\n"
+                  "Connection: close\r\n"
+                  "Content-Length: " + QByteArray::number(body.size()) + "\r\n\r\n" + body);
+    socket->disconnectFromHost();
+    ++m_requestsServed;
+}
+
+QByteArray StandInServer::timePayload() const
+{
+    const QDateTime local = m_clock->currentDateTimeUtc().addSecs(m_gmtOffsetSec);
+    const QString formatted = local.toString(QStringLiteral("yyyy-MM-dd")) + QLatin1Char('T')
+                              + local.toString(QStringLiteral("hh:mm:ss"));
+
+    return QStringLiteral(R"({"status":"OK","zoneName":"Etc/StandIn","gmtOffset":%1,"formatted":"%2"})")
+        .arg(m_gmtOffsetSec)
+        .arg(formatted)
+        .toUtf8();
+}
@@ -0,0 +1,48 @@
+#ifndef STANDINSERVER_H
+#define STANDINSERVER_H
+
+#include <QTcpServer>
+#include <QUrl>
+
+class ClockSource;
+class QTcpSocket;
+
+// Minimal local HTTP/1.1 stand-in for the weather and time APIs. Answers
+// /weather and /time with canned payloads, the time one derived from the
+// injected clock so offsets can be checked against virtual time. /weather
+// is gzip-encoded when the client accepts it. Requests to a held path wait
+// for releaseHeld(), so tests can order replies against virtual time.
+class StandInServer : public QTcpServer
+{
+    Q_OBJECT
+
+public:
+    StandInServer(const ClockSource *clock, int gmtOffsetSec, QObject *parent = nullptr);
+
+    bool listenLocal();
+    QUrl weatherUrl() const;
+    QUrl timeUrl() const;
+    int requestsServed() const;
+    int gzipServed() const;
+
+    void setHeld(const QByteArray &path, bool held);
+    int releaseHeld();
+    int heldCount() const;
+    int abortedHeld() const;    // held requests the client gave up on
+
+private:
+    void onNewConnection();
+    void onReadyRead(QTcpSocket *socket);
+    void respond(QTcpSocket *socket, const QByteArray &request);
+    QByteArray timePayload() const;
+
+    const ClockSource *m_clock;
+    int m_gmtOffsetSec;
+    int m_requestsServed = 0;
+    int m_gzipServed = 0;
+    QList<QByteArray> m_heldPaths;
+    QList<QTcpSocket *> m_held;
+    int m_abortedHeld = 0;
+};
+
+#endif // STANDINSERVER_H
@@ -0,0 +1,113 @@
+#include "virtualclock.h"
+#include <QTimeZone>
+
+class VirtualTimer : public ClockTimer
+{
+public:
+    VirtualTimer(VirtualClock *clock, QObject *parent)
+        : ClockTimer(parent)
+        , m_clock(clock)
+    {
+        m_clock->m_timers.append(this);
+    }
+
+    ~VirtualTimer() override
+    {
+        if (m_clock)
+            m_clock->m_timers.removeOne(this);
+    }
+
+    void setInterval(int msec) override
+    {
+        m_interval = msec;
+        if (m_active)
+            m_deadline = m_clock->nextDeadline(this);
+    }
+
+    int interval() const override { return m_interval; }
+
+    void start() override
+    {
+        m_active = true;
+        m_deadline = m_clock->nextDeadline(this);
+    }
+
+    void stop() override { m_active = false; }
+    bool isActive() const override { return m_active; }
+
+    VirtualClock *m_clock;
+    int m_interval = 0;
+    bool m_active = false;
+    qint64 m_deadline = 0;
+};
+
+VirtualClock::VirtualClock(const QDateTime &startUtc)
+    : m_startMs(startUtc.toMSecsSinceEpoch())
+    , m_nowMs(m_startMs)
+{
+}
+
+VirtualClock::~VirtualClock()
+{
+    for (VirtualTimer *timer : std::as_const(m_timers))
+        timer->m_clock = nullptr;
+}
+
+QDateTime VirtualClock::currentDateTimeUtc() const
+{
+    return QDateTime::fromMSecsSinceEpoch(m_nowMs, QTimeZone::UTC);
+}
+
+ClockTimer *VirtualClock::createTimer(QObject *parent)
+{
+    return new VirtualTimer(this, parent);
+}
+
+void VirtualClock::advance(qint64 msec)
+{
+    const qint64 target = m_nowMs + msec;
+
+    for (;;) {
+        VirtualTimer *due = nullptr;
+        for (VirtualTimer *timer : std::as_const(m_timers)) {
+            if (timer->m_active && timer->m_deadline <= target
+                && (!due || timer->m_deadline < due->m_deadline))
+                due = timer;
+        }
+        if (!due)
+            break;
+
+        m_nowMs = qMax(m_nowMs, due->m_deadline);
+        due->m_deadline = nextDeadline(due);
+        ++m_wakeups;
+        emit due->timeout();
+    }
+
+    m_nowMs = target;
+}
+
+qint64 VirtualClock::elapsedMs() const
+{
+    return m_nowMs - m_startMs;
+}
+
+qint64 VirtualClock::wakeups() const
+{
+    return m_wakeups;
+}
+
+void VirtualClock::setJitter(int maxMsec)
+{
+    m_jitterMs = qMax(0, maxMsec);
+}
+
+qint64 VirtualClock::nextDeadline(const VirtualTimer *timer) const
+{
+    qint64 deadline = m_nowMs + qMax(1, timer->m_interval);
+    if (m_jitterMs > 0) {
+        // Small LCG so runs are reproducible without seeding a global RNG.
+        m_seed = m_seed * 1664525u + 1013904223u;
+        deadline += (m_seed >> 8) % quint32(m_jitterMs + 1);
+    }
+    return deadline;
+}
@@ -0,0 +1,42 @@
+#ifndef VIRTUALCLOCK_H
+#define VIRTUALCLOCK_H
+
+#include "clocksource.h"
+#include <QList>
+
+class VirtualTimer;
+
+// Clock that only moves when advance() is called. Due timers fire in
+// deadline order, so weeks of ticks run as fast as the handlers allow.
+class VirtualClock : public ClockSource
+{
+public:
+    explicit VirtualClock(const QDateTime &startUtc);
+    ~VirtualClock() override;
+
+    QDateTime currentDateTimeUtc() const override;
+    ClockTimer *createTimer(QObject *parent) override;
+
+    void advance(qint64 msec);
+    qint64 elapsedMs() const;
+
+    // Every timer firing is counted as one wakeup.
+    qint64 wakeups() const;
+
+    // Delays each firing by up to maxMsec, like a coalescing OS would.
+    void setJitter(int maxMsec);
+
+private:
+    friend class VirtualTimer;
+
+    qint64 nextDeadline(const VirtualTimer *timer) const;
+
+    qint64 m_startMs;
+    qint64 m_nowMs;
+    qint64 m_wakeups = 0;
+    int m_jitterMs = 0;
+    mutable quint32 m_seed = 1;
+    QList<VirtualTimer *> m_timers;
+};
+
+#endif // VIRTUALCLOCK_H
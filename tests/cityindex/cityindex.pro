@@ -0,0 +1,15 @@
+QT = core testlib
+CONFIG += console testcase
+CONFIG -= app_bundle
+
+TARGET = tst_cityindex
+INCLUDEPATH += ../..
+DEFINES += SOURCE_DIR=\\\"$$PWD/../..\\\"
+
+SOURCES += \
+        tst_cityindex.cpp \
+        ../../cityindex.cpp
+
+HEADERS += \
+    ../../allocprofiler.h \
+    ../../cityindex.h
@@ -0,0 +1,441 @@
+#include "cityindex.h"
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QTemporaryDir>
+#include <QtEndian>
+#include <QtTest>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <tuple>
+
+namespace {
+
+// A GeoNames cities1000 dump is ~150k rows; cities15000 is ~30k.
+constexpr int kLargeSize = 150000;
+
+struct Row
+{
+    QString name;
+    QByteArray country;
+    float lat;
+    float lng;
+    quint32 population;
+};
+
+void appendU16(QByteArray &out, quint16 v)
+{
+    char b[2];
+    qToLittleEndian(v, b);
+    out.append(b, 2);
+}
+
+void appendU32(QByteArray &out, quint32 v)
+{
+    char b[4];
+    qToLittleEndian(v, b);
+    out.append(b, 4);
+}
+
+void appendF32(QByteArray &out, float v)
+{
+    quint32 bits;
+    std::memcpy(&bits, &v, sizeof bits);
+    appendU32(out, bits);
+}
+
+// Same layout and ordering as tools/build_city_index.py.
+bool writeIndex(const QString &path, QVector<Row> rows)
+{
+    QVector<QPair<QByteArray, int>> order;
+    order.reserve(rows.size());
+    for (int i = 0; i < rows.size(); ++i)
+        order.append({CityIndex::foldKey(rows[i].name), i});
+    std::sort(order.begin(), order.end(), [&](const auto &a, const auto &b) {
+        const int c = std::memcmp(a.first.constData(), b.first.constData(),
+                                  size_t(qMin(a.first.size(), b.first.size())));
+        if (c != 0)
+            return c < 0;
+        if (a.first.size() != b.first.size())
+            return a.first.size() < b.first.size();
+        return rows[a.second].population > rows[b.second].population;
+    });
+
+    QByteArray entries;
+    QByteArray strings;
+    for (const auto &[key, i] : order) {
+        const Row &row = rows[i];
+        const QByteArray name = row.name.toUtf8();
+        const quint32 keyOffset = quint32(strings.size());
+        strings += key;
+        const quint32 nameOffset = quint32(strings.size());
+        strings += name;
+
+        appendU32(entries, keyOffset);
+        appendU32(entries, nameOffset);
+        appendU32(entries, row.population);
+        appendF32(entries, row.lat);
+        appendF32(entries, row.lng);
+        appendU16(entries, quint16(key.size()));
+        appendU16(entries, quint16(name.size()));
+        entries += row.country.leftJustified(2, '\0', true);
+        appendU16(entries, 0);
+    }
+
+    QByteArray header("WCI1");
+    appendU32(header, 1);
+    appendU32(header, quint32(order.size()));
+    appendU32(header, quint32(strings.size()));
+    header += QByteArray(16, '\0');
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+    return file.write(header + entries + strings) > 0;
+}
+
+QVector<Row> smallCities()
+{
+    return {
+        {QStringLiteral("Paris"), "FR", 48.8534f, 2.3488f, 2138551},
+        {QStringLiteral("Paris"), "US", 33.6609f, -95.5555f, 24782},
+        {QStringLiteral("Parma"), "IT", 44.8015f, 10.3279f, 175895},
+        {QStringLiteral("Zürich"), "CH", 47.3667f, 8.55f, 341730},
+        {QStringLiteral("Zug"), "CH", 47.1662f, 8.5155f, 23435},
+        {QStringLiteral("São Paulo"), "BR", -23.5475f, -46.6361f, 10021295},
+        {QStringLiteral("São Tomé"), "ST", 0.3365f, 6.7273f, 53300},
+        {QStringLiteral("Kraków"), "PL", 50.0614f, 19.9366f, 755050},
+        {QStringLiteral("Łódź"), "PL", 51.75f, 19.4667f, 768755},
+        {QStringLiteral("Großenhain"), "DE", 51.2895f, 13.5332f, 18876},
+        {QStringLiteral("Reykjavík"), "IS", 64.1355f, -21.8954f, 118918},
+    };
+}
+
+QVector<Row> syntheticCities(int count)
+{
+    static const char *const syllables[] = {
+        "ba", "be", "bo", "ca", "da", "de", "fa", "ga", "ha", "ka", "ki", "la",
+        "le", "li", "lo", "ma", "me", "mi", "na", "ne", "no", "pa", "po", "ra",
+        "re", "ri", "ro", "sa", "se", "ta", "te", "to", "va", "vi", "za", "burg",
+        "stad", "ville", "polis", "grad", "ton", "dorf", "heim", "pur", "abad"
+    };
+    constexpr int syllableCount = int(sizeof syllables / sizeof *syllables);
+
+    QRandomGenerator rng(20240601);
+    QVector<Row> rows;
+    rows.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        QString name;
+        const int parts = 2 + int(rng.bounded(3));
+        for (int p = 0; p < parts; ++p)
+            name += QLatin1String(syllables[rng.bounded(syllableCount)]);
+        name[0] = name[0].toUpper();
+        if (rng.bounded(8) == 0)
+            name.prepend(QStringLiteral("San "));
+
+        const char cc[2] = {char('A' + rng.bounded(26)), char('A' + rng.bounded(26))};
+        rows.append({name, QByteArray(cc, 2),
+                     float(rng.bounded(180.0) - 90.0), float(rng.bounded(360.0) - 180.0),
+                     quint32(1000 + rng.bounded(5000000))});
+    }
+    return rows;
+}
+
+// One random edit, the kind of slip the typo pass has to absorb.
+QString misspell(QString name, QRandomGenerator &rng)
+{
+    const int at = int(rng.bounded(int(name.size())));
+    const QChar letter(char16_t(u'a' + rng.bounded(26)));
+    switch (rng.bounded(4)) {
+    case 0: name[at] = letter; break;
+    case 1: name.remove(at, 1); break;
+    case 2: name.insert(at, letter); break;
+    default:
+        if (at + 1 < name.size())
+            std::swap(name[at], name[at + 1]);
+        break;
+    }
+    return name;
+}
+
+// Straightforward reference for typo matching: the optimal string
+// alignment distance between the query and the closest prefix of key.
+int referenceDistance(const QByteArray &query, const QByteArray &key)
+{
+    const int m = int(query.size());
+    QVector<QVector<int>> d(key.size() + 1, QVector<int>(m + 1));
+    for (int i = 0; i <= m; ++i)
+        d[0][i] = i;
+    int best = m;
+    for (int j = 1; j <= key.size(); ++j) {
+        d[j][0] = j;
+        for (int i = 1; i <= m; ++i) {
+            int v = qMin(qMin(d[j - 1][i] + 1, d[j][i - 1] + 1),
+                         d[j - 1][i - 1] + (query[i - 1] == key[j - 1] ? 0 : 1));
+            if (i > 1 && j > 1 && query[i - 1] == key[j - 2] && query[i - 2] == key[j - 1])
+                v = qMin(v, d[j - 2][i - 2] + 1);
+            d[j][i] = v;
+        }
+        best = qMin(best, d[j][m]);
+    }
+    return best;
+}
+
+} // namespace
+
+class tst_CityIndex : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void prefix_data();
+    void prefix();
+    void accentFolding_data();
+    void accentFolding();
+    void oneEditTypos_data();
+    void oneEditTypos();
+    void emptyQuery();
+    void typosMatchBruteForce();
+
+    void bundledIndex();
+    void keystrokeLatency();
+    void searchLatency_data();
+    void searchLatency();
+
+private:
+    QStringList labels(const QVector<CityIndex::Match> &matches) const;
+
+    QTemporaryDir m_dir;
+    CityIndex m_small;
+    QVector<Row> m_largeRows;
+    CityIndex m_large;
+};
+
+void tst_CityIndex::initTestCase()
+{
+    QVERIFY(m_dir.isValid());
+    const QString smallPath = m_dir.filePath(QStringLiteral("small.bin"));
+    QVERIFY(writeIndex(smallPath, smallCities()));
+    QVERIFY(m_small.load(smallPath));
+
+    m_largeRows = syntheticCities(kLargeSize);
+    const QString path = m_dir.filePath(QStringLiteral("large.bin"));
+    QVERIFY(writeIndex(path, m_largeRows));
+    QVERIFY(m_large.load(path));
+    QCOMPARE(m_large.size(), kLargeSize);
+}
+
+QStringList tst_CityIndex::labels(const QVector<CityIndex::Match> &matches) const
+{
+    QStringList out;
+    for (const CityIndex::Match &m : matches)
+        out << m_small.name(m.entry) + QLatin1Char('/') + m_small.country(m.entry);
+    return out;
+}
+
+void tst_CityIndex::prefix_data()
+{
+    QTest::addColumn<QString>("query");
+    QTest::addColumn<QStringList>("expected");
+
+    QTest::newRow("ranked by population") << QStringLiteral("par")
+        << QStringList{"Paris/FR", "Parma/IT", "Paris/US"};
+    QTest::newRow("case") << QStringLiteral("PARIS")
+        << QStringList{"Paris/FR", "Paris/US"};
+    QTest::newRow("single letter") << QStringLiteral("z")
+        << QStringList{"Zürich/CH", "Zug/CH"};
+    QTest::newRow("multi word") << QStringLiteral("sao p")
+        << QStringList{"São Paulo/BR"};
+    QTest::newRow("punctuation as space") << QStringLiteral("sao-tome")
+        << QStringList{"São Tomé/ST"};
+}
+
+void tst_CityIndex::prefix()
+{
+    QFETCH(QString, query);
+    QFETCH(QStringList, expected);
+
+    const QVector<CityIndex::Match> matches = m_small.search(query, int(expected.size()));
+    QCOMPARE(labels(matches), expected);
+    for (const CityIndex::Match &m : matches)
+        QCOMPARE(m.distance, 0);
+}
+
+void tst_CityIndex::accentFolding_data()
+{
+    QTest::addColumn<QString>("query");
+    QTest::addColumn<QString>("expected");
+
+    QTest::newRow("plain for umlaut") << QStringLiteral("zurich") << QStringLiteral("Zürich/CH");
+    QTest::newRow("umlaut for umlaut") << QStringLiteral("ZÜRICH") << QStringLiteral("Zürich/CH");
+    QTest::newRow("tilde") << QStringLiteral("sao paulo") << QStringLiteral("São Paulo/BR");
+    QTest::newRow("acute") << QStringLiteral("krakow") << QStringLiteral("Kraków/PL");
+    QTest::newRow("stroke") << QStringLiteral("lodz") << QStringLiteral("Łódź/PL");
+    QTest::newRow("sharp s") << QStringLiteral("grossen") << QStringLiteral("Großenhain/DE");
+    QTest::newRow("sharp s typed") << QStringLiteral("Großen") << QStringLiteral("Großenhain/DE");
+    QTest::newRow("accent typed") << QStringLiteral("reykjavík") << QStringLiteral("Reykjavík/IS");
+}
+
+void tst_CityIndex::accentFolding()
+{
+    QFETCH(QString, query);
+    QFETCH(QString, expected);
+
+    const QVector<CityIndex::Match> matches = m_small.search(query, 1);
+    QCOMPARE(labels(matches), QStringList{expected});
+    QCOMPARE(matches[0].distance, 0);
+}
+
+void tst_CityIndex::oneEditTypos_data()
+{
+    QTest::addColumn<QString>("query");
+    QTest::addColumn<QString>("expected");
+
+    QTest::newRow("substitution") << QStringLiteral("krakiw") << QStringLiteral("Kraków/PL");
+    QTest::newRow("deletion") << QStringLiteral("zuich") << QStringLiteral("Zürich/CH");
+    QTest::newRow("insertion") << QStringLiteral("zuerich") << QStringLiteral("Zürich/CH");
+    QTest::newRow("transposition") << QStringLiteral("zurihc") << QStringLiteral("Zürich/CH");
+    QTest::newRow("swapped first pair") << QStringLiteral("apris") << QStringLiteral("Paris/FR");
+    QTest::newRow("stray first letter") << QStringLiteral("xparis") << QStringLiteral("Paris/FR");
+    QTest::newRow("typo in partial word") << QStringLiteral("raykj") << QStringLiteral("Reykjavík/IS");
+}
+
+void tst_CityIndex::oneEditTypos()
+{
+    QFETCH(QString, query);
+    QFETCH(QString, expected);
+
+    const QVector<CityIndex::Match> matches = m_small.search(query, 1);
+    QCOMPARE(labels(matches), QStringList{expected});
+    QVERIFY(matches[0].distance <= 1);
+}
+
+void tst_CityIndex::emptyQuery()
+{
+    QVERIFY(m_small.search(QString(), 10).isEmpty());
+    QVERIFY(m_small.search(QStringLiteral("  ,. "), 10).isEmpty());
+    QVERIFY(m_small.search(QStringLiteral("paris"), 0).isEmpty());
+    QVERIFY(m_small.search(QStringLiteral("qqqq"), 10).isEmpty());
+}
+
+// Checks the ranked typo results on the large index against scanning
+// every entry, including first-letter slips and two-edit queries.
+void tst_CityIndex::typosMatchBruteForce()
+{
+    QVector<QByteArray> keys;
+    keys.reserve(m_largeRows.size());
+    for (const Row &row : std::as_const(m_largeRows))
+        keys.append(CityIndex::foldKey(row.name));
+
+    QRandomGenerator rng(11);
+    for (int n = 0; n < 60; ++n) {
+        QString name = m_largeRows[rng.bounded(kLargeSize)].name;
+        name = misspell(n % 3 ? misspell(name, rng) : name, rng);
+        const QByteArray query = CityIndex::foldKey(name.left(3 + rng.bounded(int(name.size()))));
+        if (query.size() < 3)
+            continue;
+
+        const int maxDist = query.size() >= 7 ? 2 : 1;
+        QVector<std::tuple<int, quint32, QByteArray>> expected;
+        for (int i = 0; i < keys.size(); ++i) {
+            if (keys[i].startsWith(query))
+                expected.append({0, m_largeRows[i].population, keys[i]});
+            else if (const int d = referenceDistance(query, keys[i]); d <= maxDist)
+                expected.append({d, m_largeRows[i].population, keys[i]});
+        }
+        std::sort(expected.begin(), expected.end(), [](const auto &a, const auto &b) {
+            if (std::get<0>(a) != std::get<0>(b))
+                return std::get<0>(a) < std::get<0>(b);
+            if (std::get<1>(a) != std::get<1>(b))
+                return std::get<1>(a) > std::get<1>(b);
+            return std::get<2>(a) < std::get<2>(b);
+        });
+        expected.resize(qMin(int(expected.size()), 10));
+
+        QVector<std::tuple<int, quint32, QByteArray>> got;
+        for (const CityIndex::Match &m : m_large.search(QString::fromUtf8(query), 10))
+            got.append({m.distance, m_large.population(m.entry), CityIndex::foldKey(m_large.name(m.entry))});
+        QVERIFY2(got == expected, query.constData());
+    }
+}
+
+void tst_CityIndex::bundledIndex()
+{
+    CityIndex index;
+    QVERIFY(index.load(QStringLiteral(SOURCE_DIR "/data/cities.bin")));
+
+    for (int i = 0; i < index.size(); ++i)
+        QVERIFY2(index.country(i).size() == 2, qPrintable(index.name(i)));
+
+    const QVector<CityIndex::Match> vienna = index.search(QStringLiteral("vienna"), 1);
+    QCOMPARE(int(vienna.size()), 1);
+    QCOMPARE(index.name(vienna[0].entry), QStringLiteral("Vienna"));
+    QCOMPARE(index.country(vienna[0].entry), QStringLiteral("AT"));
+}
+
+// Replays typing a city name one character at a time, which is what the
+// search field does, half of them with a typo, and checks the slowest
+// keystrokes rather than the average. Each keystroke keeps its best of a
+// few runs so a context switch on a busy machine is not taken for a slow
+// search.
+void tst_CityIndex::keystrokeLatency()
+{
+    QRandomGenerator rng(7);
+    QElapsedTimer timer;
+    QVector<qint64> samples;
+
+    for (int n = 0; n < 500; ++n) {
+        QString name = m_largeRows[rng.bounded(kLargeSize)].name;
+        if (n % 2)
+            name = misspell(name, rng);
+        for (int len = 1; len <= name.size(); ++len) {
+            const QString typed = name.left(len);
+            qint64 best = std::numeric_limits<qint64>::max();
+            for (int run = 0; run < 3; ++run) {
+                timer.start();
+                const QVector<CityIndex::Match> matches = m_large.search(typed, 10);
+                best = qMin(best, timer.nsecsElapsed());
+                QVERIFY(!matches.isEmpty() || len < 3);
+            }
+            samples.append(best);
+        }
+    }
+
+    std::sort(samples.begin(), samples.end());
+    const double p99Ms = double(samples[samples.size() * 99 / 100]) / 1e6;
+    const double worstMs = double(samples.last()) / 1e6;
+    qInfo("%d keystrokes over %d cities: median %.3f ms, p99 %.3f ms, worst %.3f ms",
+          int(samples.size()), kLargeSize, double(samples[samples.size() / 2]) / 1e6,
+          p99Ms, worstMs);
+#ifdef QT_NO_DEBUG
+    QVERIFY2(p99Ms < 1.0, "p99 keystroke is over the 1 ms budget");
+    QVERIFY2(worstMs < 1.0, "slowest keystroke is over the 1 ms budget");
+#endif
+}
+
+void tst_CityIndex::searchLatency_data()
+{
+    QTest::addColumn<QString>("query");
+
+    QTest::newRow("one letter") << QStringLiteral("m");
+    QTest::newRow("prefix") << QStringLiteral("mar");
+    QTest::newRow("long prefix") << QStringLiteral("marlobu");
+    QTest::newRow("typo") << QStringLiteral("mralobu");
+    QTest::newRow("long typo") << QStringLiteral("san bolakidorf");
+    QTest::newRow("no match") << QStringLiteral("qqqqq");
+}
+
+void tst_CityIndex::searchLatency()
+{
+    QFETCH(QString, query);
+
+    QBENCHMARK {
+        m_large.search(query, 10);
+    }
+}
+
+QTEST_APPLESS_MAIN(tst_CityIndex)
+
+#include "tst_cityindex.moc"
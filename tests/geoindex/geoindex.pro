@@ -0,0 +1,13 @@
+QT = core testlib
+CONFIG += console testcase
+CONFIG -= app_bundle
+
+TARGET = tst_geoindex
+INCLUDEPATH += ../..
+
+SOURCES += \
+        tst_geoindex.cpp \
+        ../../geoindex.cpp
+
+HEADERS += \
+    ../../geoindex.h
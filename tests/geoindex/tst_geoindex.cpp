@@ -0,0 +1,201 @@
+#include "geoindex.h"
+#include <QRandomGenerator>
+#include <QtMath>
+#include <QtTest>
+#include <algorithm>
+
+namespace {
+
+constexpr double kEarthRadiusKm = 6371.0088;
+constexpr double kToleranceKm = 1e-3;
+
+// Independent of GeoIndex's chord arithmetic on purpose.
+double haversineKm(double lat1, double lng1, double lat2, double lng2)
+{
+    const double p1 = qDegreesToRadians(lat1);
+    const double p2 = qDegreesToRadians(lat2);
+    const double dp = p2 - p1;
+    const double dl = qDegreesToRadians(lng2 - lng1);
+    const double a = qSin(dp / 2) * qSin(dp / 2) + qCos(p1) * qCos(p2) * qSin(dl / 2) * qSin(dl / 2);
+    return 2.0 * kEarthRadiusKm * qAsin(qMin(1.0, qSqrt(a)));
+}
+
+// Uniform points plus dense clusters straddling the antimeridian and
+// around both poles, where a lat/lng tree would break.
+QVector<GeoPoint> testPoints()
+{
+    QRandomGenerator rng(1234);
+    QVector<GeoPoint> points;
+    for (int i = 0; i < 4000; ++i)
+        points.append({qRadiansToDegrees(qAsin(rng.bounded(2.0) - 1.0)), rng.bounded(360.0) - 180.0});
+    for (int i = 0; i < 500; ++i) {
+        const double lng = rng.bounded(2.0) - 1.0;
+        points.append({rng.bounded(20.0) - 10.0, lng < 0 ? -180.0 - lng : 180.0 - lng});
+    }
+    for (int i = 0; i < 500; ++i) {
+        const double lat = 89.0 + rng.bounded(1.0);
+        points.append({i % 2 ? lat : -lat, rng.bounded(360.0) - 180.0});
+    }
+    points.append({90.0, 0.0});
+    points.append({-90.0, 0.0});
+    points.append({0.0, 180.0});
+    points.append({0.0, -180.0});
+    return points;
+}
+
+QVector<GeoIndex::Hit> bruteForce(const QVector<GeoPoint> &points, double lat, double lng)
+{
+    QVector<GeoIndex::Hit> hits;
+    for (int i = 0; i < points.size(); ++i)
+        hits.append({i, haversineKm(lat, lng, points[i].lat, points[i].lng)});
+    std::sort(hits.begin(), hits.end(), [](const GeoIndex::Hit &a, const GeoIndex::Hit &b) {
+        return a.distanceKm < b.distanceKm;
+    });
+    return hits;
+}
+
+} // namespace
+
+class tst_GeoIndex : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void nearestMatchesBruteForce_data() { addQueries(); }
+    void nearestMatchesBruteForce();
+    void withinRadiusMatchesBruteForce_data() { addQueries(); }
+    void withinRadiusMatchesBruteForce();
+
+    void acrossAntimeridian();
+    void acrossPole();
+    void emptyIndex();
+
+private:
+    static void addQueries();
+
+    QVector<GeoPoint> m_points;
+    GeoIndex m_index;
+};
+
+void tst_GeoIndex::initTestCase()
+{
+    m_points = testPoints();
+    m_index.build(m_points);
+    QCOMPARE(m_index.size(), int(m_points.size()));
+}
+
+void tst_GeoIndex::addQueries()
+{
+    QTest::addColumn<double>("lat");
+    QTest::addColumn<double>("lng");
+
+    QTest::newRow("vienna") << 48.2082 << 16.3738;
+    QTest::newRow("equator") << 0.0 << 0.0;
+    QTest::newRow("antimeridian east") << 5.0 << 179.95;
+    QTest::newRow("antimeridian west") << -5.0 << -179.95;
+    QTest::newRow("antimeridian exact") << 0.0 << 180.0;
+    QTest::newRow("north pole") << 90.0 << 0.0;
+    QTest::newRow("north pole other lng") << 90.0 << 137.0;
+    QTest::newRow("near south pole") << -89.99 << -73.0;
+    QTest::newRow("empty ocean") << -48.8767 << -123.3933;
+
+    QRandomGenerator rng(99);
+    for (int i = 0; i < 20; ++i)
+        QTest::addRow("random %d", i) << rng.bounded(180.0) - 90.0 << rng.bounded(360.0) - 180.0;
+}
+
+void tst_GeoIndex::nearestMatchesBruteForce()
+{
+    QFETCH(double, lat);
+    QFETCH(double, lng);
+
+    const QVector<GeoIndex::Hit> expected = bruteForce(m_points, lat, lng);
+    for (const int k : {1, 5, 25}) {
+        const QVector<GeoIndex::Hit> hits = m_index.nearest(lat, lng, k);
+        QCOMPARE(int(hits.size()), k);
+        for (int i = 0; i < k; ++i) {
+            // Ties may come back in either order, so compare distances and
+            // check each id really is at the distance reported for it.
+            QVERIFY2(qAbs(hits[i].distanceKm - expected[i].distanceKm) < kToleranceKm,
+                     qPrintable(QStringLiteral("k=%1 rank %2: %3 km, expected %4 km")
+                                    .arg(k).arg(i).arg(hits[i].distanceKm).arg(expected[i].distanceKm)));
+            const GeoPoint &p = m_points[hits[i].id];
+            QVERIFY(qAbs(haversineKm(lat, lng, p.lat, p.lng) - hits[i].distanceKm) < kToleranceKm);
+        }
+    }
+}
+
+void tst_GeoIndex::withinRadiusMatchesBruteForce()
+{
+    QFETCH(double, lat);
+    QFETCH(double, lng);
+
+    const QVector<GeoIndex::Hit> all = bruteForce(m_points, lat, lng);
+    for (const double radius : {1.0, 50.0, 500.0, 3000.0, 25000.0}) {
+        QVector<int> expected;
+        QVector<int> borderline;
+        for (const GeoIndex::Hit &h : all) {
+            if (h.distanceKm < radius - kToleranceKm)
+                expected.append(h.id);
+            else if (h.distanceKm <= radius + kToleranceKm)
+                borderline.append(h.id);
+        }
+
+        QVector<int> got;
+        for (const GeoIndex::Hit &h : m_index.withinRadius(lat, lng, radius)) {
+            QVERIFY(h.distanceKm <= radius + kToleranceKm);
+            if (!borderline.contains(h.id))
+                got.append(h.id);
+        }
+
+        std::sort(expected.begin(), expected.end());
+        std::sort(got.begin(), got.end());
+        QCOMPARE(got, expected);
+    }
+}
+
+void tst_GeoIndex::acrossAntimeridian()
+{
+    GeoIndex index;
+    index.build({{0.0, 179.9}, {0.0, 170.0}, {0.0, -170.0}});
+
+    const QVector<GeoIndex::Hit> hits = index.nearest(0.0, -179.9, 1);
+    QCOMPARE(int(hits.size()), 1);
+    QCOMPARE(hits[0].id, 0);
+    QVERIFY(qAbs(hits[0].distanceKm - haversineKm(0.0, 179.9, 0.0, -179.9)) < kToleranceKm);
+    QVERIFY(hits[0].distanceKm < 25.0);
+
+    QCOMPARE(int(index.withinRadius(0.0, 180.0, 20.0).size()), 1);
+}
+
+void tst_GeoIndex::acrossPole()
+{
+    GeoIndex index;
+    index.build({{89.9, 0.0}, {89.9, 180.0}, {89.0, 90.0}, {-89.9, 0.0}});
+
+    // Opposite meridians are ~22 km apart over the pole.
+    const QVector<GeoIndex::Hit> hits = index.nearest(89.9, 0.0, 2);
+    QCOMPARE(int(hits.size()), 2);
+    QCOMPARE(hits[0].id, 0);
+    QCOMPARE(hits[1].id, 1);
+    QVERIFY(hits[1].distanceKm < 25.0);
+
+    // Every longitude is the same point at the pole.
+    const QVector<GeoIndex::Hit> fromPole = index.withinRadius(90.0, -42.0, 12.0);
+    QCOMPARE(int(fromPole.size()), 2);
+}
+
+void tst_GeoIndex::emptyIndex()
+{
+    GeoIndex index;
+    index.build({});
+    QVERIFY(index.nearest(0.0, 0.0, 3).isEmpty());
+    QVERIFY(index.withinRadius(0.0, 0.0, 1000.0).isEmpty());
+    QVERIFY(m_index.nearest(0.0, 0.0, 0).isEmpty());
+}
+
+QTEST_APPLESS_MAIN(tst_GeoIndex)
+
+#include "tst_geoindex.moc"
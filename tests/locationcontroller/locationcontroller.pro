@@ -0,0 +1,32 @@
+QT = core network testlib
+CONFIG += console testcase
+CONFIG -= app_bundle
+
+TARGET = tst_locationcontroller
+INCLUDEPATH += ../.. ../../soak
+
+SOURCES += \
+        tst_locationcontroller.cpp \
+        ../../soak/standinserver.cpp \
+        ../../soak/virtualclock.cpp \
+        ../../cityindex.cpp \
+        ../../clocksource.cpp \
+        ../../geoindex.cpp \
+        ../../locationcontroller.cpp \
+        ../../networkclient.cpp \
+        ../../timebackend.cpp \
+        ../../weatherbackend.cpp
+
+HEADERS += \
+    ../../soak/standinserver.h \
+    ../../soak/virtualclock.h \
+    ../../allocprofiler.h \
+    ../../cityindex.h \
+    ../../clocksource.h \
+    ../../geoindex.h \
+    ../../locationcontroller.h \
+    ../../networkclient.h \
+    ../../timebackend.h \
+    ../../weatherbackend.h
+
+include(../../zlib.pri)
@@ -0,0 +1,215 @@
+#include "locationcontroller.h"
+#include "standinserver.h"
+#include "virtualclock.h"
+#include <QtTest>
+#include <memory>
+
+namespace {
+
+constexpr int kGmtOffsetSec = 3600;
+
+// What the stand-in's time reply reads at the test clock's start.
+const char *kPublishedTime = "01/01/2025 01:00:00";
+const char *kNoTime = "--:--";
+
+} // namespace
+
+// Runs LocationController against the soak stand-in on a virtual clock.
+// Held paths let each test decide which part arrives, and when.
+class tst_LocationController : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void publishesOneSnapshot();
+    void timeoutClearsMissingPart();
+    void newerSelectionWins();
+    void lateRepliesDropped();
+    void lateRefreshDropped();
+
+private:
+    VirtualClock m_clock{QDateTime(QDate(2025, 1, 1), QTime(0, 0), QTimeZone::UTC)};
+    StandInServer m_server{&m_clock, kGmtOffsetSec};
+    std::unique_ptr<NetworkClient> m_network;
+    std::unique_ptr<WeatherBackend> m_weather;
+    std::unique_ptr<TimeBackend> m_time;
+    std::unique_ptr<LocationController> m_controller;
+    int m_completed = 0;
+};
+
+void tst_LocationController::initTestCase()
+{
+    QVERIFY(m_server.listenLocal());
+    // Read once by the backends' URL helpers, so set before first use.
+    qputenv("WEATHER_API_BASE", m_server.weatherUrl().toString().toUtf8());
+    qputenv("TIME_API_BASE", m_server.timeUrl().toString().toUtf8());
+}
+
+void tst_LocationController::init()
+{
+    m_completed = 0;
+    m_network = std::make_unique<NetworkClient>();
+    connect(m_network.get(), &NetworkClient::statsChanged, this, [this]() { ++m_completed; });
+    m_weather = std::make_unique<WeatherBackend>(m_network.get());
+    m_time = std::make_unique<TimeBackend>(m_network.get(), &m_clock);
+    m_controller = std::make_unique<LocationController>(m_weather.get(), m_time.get(), &m_clock);
+}
+
+void tst_LocationController::cleanup()
+{
+    m_server.setHeld("/weather", false);
+    m_server.setHeld("/time", false);
+    m_server.releaseHeld();
+
+    m_controller.reset();
+    m_time.reset();
+    m_weather.reset();
+    m_network.reset();
+}
+
+void tst_LocationController::publishesOneSnapshot()
+{
+    QSignalSpy snapshots(m_controller.get(), &LocationController::snapshotReady);
+    QSignalSpy weatherUpdates(m_weather.get(), &WeatherBackend::weatherUpdated);
+    QSignalSpy errors(m_controller.get(), &LocationController::errorOccurred);
+
+    m_controller->selectLocation(QStringLiteral("Paris"), 48.8566, 2.3522);
+    QVERIFY(m_controller->loading());
+
+    QTRY_COMPARE(snapshots.count(), 1);
+    QVERIFY(!m_controller->loading());
+    QCOMPARE(m_controller->locationName(), QStringLiteral("Paris"));
+    QCOMPARE(m_weather->cityName(), QStringLiteral("Stand-in"));
+    QCOMPARE(m_time->timeString(), QString::fromLatin1(kPublishedTime));
+    QCOMPARE(weatherUpdates.count(), 1);
+    QVERIFY(errors.isEmpty());
+
+    QCOMPARE(m_completed, m_network->requestCount());
+    QCoreApplication::processEvents();
+    QCOMPARE(snapshots.count(), 1);
+}
+
+void tst_LocationController::timeoutClearsMissingPart()
+{
+    QSignalSpy snapshots(m_controller.get(), &LocationController::snapshotReady);
+    QSignalSpy errors(m_controller.get(), &LocationController::errorOccurred);
+    m_server.setHeld("/time", true);
+
+    m_controller->selectLocation(QStringLiteral("Paris"), 48.8566, 2.3522);
+    QTRY_COMPARE(m_server.heldCount(), 1);
+    QTRY_COMPARE(m_completed, 1);
+    QCoreApplication::processEvents();   // the weather continuation is queued
+
+    // Half a snapshot is never published before the timeout.
+    m_clock.advance(m_controller->timeoutMs() - 1);
+    QVERIFY(snapshots.isEmpty());
+    QVERIFY(m_controller->loading());
+
+    m_clock.advance(1);
+    QCOMPARE(snapshots.count(), 1);
+    QVERIFY(!m_controller->loading());
+    QCOMPARE(m_controller->locationName(), QStringLiteral("Paris"));
+    QCOMPARE(m_weather->cityName(), QStringLiteral("Stand-in"));
+    QCOMPARE(m_time->timeString(), QString::fromLatin1(kNoTime));
+    QCOMPARE(errors.count(), 1);
+    QCOMPARE(errors.at(0).at(0).toString(), QStringLiteral("Time request timed out"));
+
+    // The open time request is aborted rather than left to the server.
+    QTRY_COMPARE(m_server.abortedHeld(), 1);
+    QTRY_COMPARE(m_completed, m_network->requestCount());
+}
+
+void tst_LocationController::newerSelectionWins()
+{
+    QSignalSpy snapshots(m_controller.get(), &LocationController::snapshotReady);
+    QSignalSpy errors(m_controller.get(), &LocationController::errorOccurred);
+    m_server.setHeld("/weather", true);
+    m_server.setHeld("/time", true);
+
+    m_controller->selectLocation(QStringLiteral("Paris"), 48.8566, 2.3522);
+    QTRY_COMPARE(m_server.heldCount(), 2);
+
+    m_controller->selectLocation(QStringLiteral("Vienna"), 48.2082, 16.3738);
+    QTRY_COMPARE(m_server.abortedHeld(), 2);
+    QTRY_COMPARE(m_server.heldCount(), 2);
+    QVERIFY(snapshots.isEmpty());
+
+    m_server.setHeld("/weather", false);
+    m_server.setHeld("/time", false);
+    QCOMPARE(m_server.releaseHeld(), 2);
+
+    QTRY_COMPARE(snapshots.count(), 1);
+    QCOMPARE(m_controller->locationName(), QStringLiteral("Vienna"));
+    QCOMPARE(m_time->timeString(), QString::fromLatin1(kPublishedTime));
+    QVERIFY(!m_controller->loading());
+    QVERIFY(errors.isEmpty());
+
+    QTRY_COMPARE(m_completed, m_network->requestCount());
+    QCoreApplication::processEvents();
+    QCOMPARE(snapshots.count(), 1);
+}
+
+// The held reply goes out in the same pass as the timeout, racing the
+// abort. Whichever wins, the snapshot already published must stand.
+void tst_LocationController::lateRepliesDropped()
+{
+    QSignalSpy snapshots(m_controller.get(), &LocationController::snapshotReady);
+    QSignalSpy errors(m_controller.get(), &LocationController::errorOccurred);
+    m_server.setHeld("/time", true);
+
+    m_controller->selectLocation(QStringLiteral("Paris"), 48.8566, 2.3522);
+    QTRY_COMPARE(m_server.heldCount(), 1);
+    QTRY_COMPARE(m_completed, 1);
+    QCoreApplication::processEvents();
+
+    m_clock.advance(m_controller->timeoutMs());
+    QCOMPARE(snapshots.count(), 1);
+    QSignalSpy timeUpdates(m_time.get(), &TimeBackend::timeUpdated);
+
+    m_server.setHeld("/time", false);
+    QCOMPARE(m_server.releaseHeld(), 1);
+    QTRY_COMPARE(m_completed, m_network->requestCount());
+    QCoreApplication::processEvents();
+
+    QCOMPARE(snapshots.count(), 1);
+    QCOMPARE(errors.count(), 1);
+    QVERIFY(timeUpdates.isEmpty());
+    QCOMPARE(m_time->timeString(), QString::fromLatin1(kNoTime));
+    QVERIFY(!m_controller->loading());
+}
+
+// An auto-refresh for the previous position that lands after a snapshot
+// must neither overwrite the time nor flip loading.
+void tst_LocationController::lateRefreshDropped()
+{
+    QSignalSpy snapshots(m_controller.get(), &LocationController::snapshotReady);
+    m_server.setHeld("/time", true);
+
+    m_time->fetchTimeDataAt(35.6762, 139.6503);
+    QTRY_COMPARE(m_server.heldCount(), 1);
+    QVERIFY(m_time->loading());
+    m_server.setHeld("/time", false);
+
+    m_controller->selectLocation(QStringLiteral("Vienna"), 48.2082, 16.3738);
+    QTRY_COMPARE(snapshots.count(), 1);
+    QCOMPARE(m_time->timeString(), QString::fromLatin1(kPublishedTime));
+    QVERIFY(!m_time->loading());
+
+    QSignalSpy timeUpdates(m_time.get(), &TimeBackend::timeUpdated);
+    QSignalSpy loadingChanges(m_time.get(), &TimeBackend::loadingChanged);
+    QCOMPARE(m_server.releaseHeld(), 1);
+    QTRY_COMPARE(m_completed, m_network->requestCount());
+    QCoreApplication::processEvents();
+
+    QVERIFY(timeUpdates.isEmpty());
+    QVERIFY(loadingChanges.isEmpty());
+    QVERIFY(!m_time->loading());
+}
+
+QTEST_GUILESS_MAIN(tst_LocationController)
+
+#include "tst_locationcontroller.moc"
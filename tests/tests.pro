@@ -0,0 +1,7 @@
+# Unit tests and benchmarks: qmake tests/tests.pro && make && make check
+TEMPLATE = subdirs
+SUBDIRS = \
+    cityindex \
+    geoindex \
+    locationcontroller \
+    timebackend
@@ -0,0 +1,25 @@
+QT = core network testlib
+CONFIG += console testcase
+CONFIG -= app_bundle
+
+TARGET = tst_timebackend
+INCLUDEPATH += ../..
+DEFINES += SOURCE_DIR=\\\"$$PWD/../..\\\"
+
+SOURCES += \
+        tst_timebackend.cpp \
+        ../../cityindex.cpp \
+        ../../clocksource.cpp \
+        ../../geoindex.cpp \
+        ../../networkclient.cpp \
+        ../../timebackend.cpp
+
+HEADERS += \
+    ../../allocprofiler.h \
+    ../../cityindex.h \
+    ../../clocksource.h \
+    ../../geoindex.h \
+    ../../networkclient.h \
+    ../../timebackend.h
+
+include(../../zlib.pri)
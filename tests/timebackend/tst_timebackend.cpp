@@ -0,0 +1,89 @@
+#include "timebackend.h"
+#include <QtTest>
+
+namespace {
+
+// The closest distinct places in the bundled data are the capitals of Italy
+// and Vatican City, ~3.6 km apart; anything nearer is one place twice.
+constexpr double kSamePlaceKm = 1.0;
+
+GeoPoint pointOf(const QVariant &hit)
+{
+    const QVariantMap map = hit.toMap();
+    return {map.value("lat").toDouble(), map.value("lng").toDouble()};
+}
+
+QString labelOf(const QVariant &hit)
+{
+    const QVariantMap map = hit.toMap();
+    return map.value("name").toString() + QLatin1Char('/') + map.value("country").toString();
+}
+
+} // namespace
+
+class tst_TimeBackend : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void bundledCapitalsNotDuplicated();
+    void capitalHitsUseIsoCode();
+    void capitalsWithoutCityIndex();
+
+private:
+    CityIndex m_index;
+};
+
+void tst_TimeBackend::initTestCase()
+{
+    QVERIFY(m_index.load(QStringLiteral(SOURCE_DIR "/data/cities.bin")));
+}
+
+// Every capital is also in the bundled city index; looking up around any
+// city must never return one place twice.
+void tst_TimeBackend::bundledCapitalsNotDuplicated()
+{
+    TimeBackend backend;
+    backend.setCityIndex(&m_index);
+
+    for (int i = 0; i < m_index.size(); ++i) {
+        const QVariantList hits = backend.nearestLocations(m_index.latitude(i), m_index.longitude(i), 2);
+        QCOMPARE(int(hits.size()), 2);
+        const double apartKm = GeoIndex::distanceKm(pointOf(hits[0]), pointOf(hits[1]));
+        QVERIFY2(apartKm > kSamePlaceKm,
+                 qPrintable(QStringLiteral("%1 and %2 are %3 km apart")
+                                .arg(labelOf(hits[0]), labelOf(hits[1])).arg(apartKm)));
+    }
+}
+
+void tst_TimeBackend::capitalHitsUseIsoCode()
+{
+    TimeBackend backend;
+    backend.setCityIndex(&m_index);
+
+    const QVariantList paris = backend.nearestLocations(48.8566, 2.3522, 1);
+    QCOMPARE(int(paris.size()), 1);
+    QCOMPARE(labelOf(paris[0]), QStringLiteral("France/FR"));
+    QVERIFY(paris[0].toMap().value("distanceKm").toDouble() < kSamePlaceKm);
+
+    // Capitals and city entries alike.
+    const QVariantList around = backend.locationsWithinRadius(48.8566, 2.3522, 1500.0);
+    QVERIFY(around.size() > 1);
+    for (const QVariant &hit : around)
+        QVERIFY2(hit.toMap().value("country").toString().size() == 2, qPrintable(labelOf(hit)));
+}
+
+void tst_TimeBackend::capitalsWithoutCityIndex()
+{
+    TimeBackend backend;
+
+    const QVariantList vienna = backend.nearestLocations(48.2, 16.37, 1);
+    QCOMPARE(int(vienna.size()), 1);
+    QCOMPARE(labelOf(vienna[0]), QStringLiteral("Austria/AT"));
+}
+
+QTEST_GUILESS_MAIN(tst_TimeBackend)
+
+#include "tst_timebackend.moc"
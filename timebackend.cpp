@@ -1,13 +1,17 @@
 #include "timebackend.h"
+#include "allocprofiler.h"
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QDebug>
+#include <QFutureWatcher>
+#include <QPromise>
+#include <memory>
 
 namespace {
 
 inline const QString &timeApiBase()
 {
-    static const QString v = QStringLiteral("https://api.timezonedb.com/v2.1/get-time-zone");
+    static const QString v = qEnvironmentVariable("TIME_API_BASE", QStringLiteral("https://api.timezonedb.com/v2.1/get-time-zone"));
     return v;
 }
 
@@ -20,6 +24,9 @@ inline const QString &timeApiKey()
 inline int apiSyncMs() { return 5 * 60 * 1000; }  // 5 minutes
 inline int localTickMs() { return 1000; }         // 1 second
 
+// How far a city index may place a capital from the country list's point.
+constexpr double kDuplicateKm = 25.0;
+
 inline const QString &timeFmt()
 {
     static const QString v = QStringLiteral("dd/MM/yyyy hh:mm:ss");
@@ -30,253 +37,353 @@ inline const QString &timeFmt()
 
 using namespace std;
 
-TimeBackend::TimeBackend(QObject *parent)
+TimeBackend::TimeBackend(NetworkClient *network, ClockSource *clock, QObject *parent)
     : QObject(parent)
-    , m_updateTimer(new QTimer(this))
-    , m_networkManager(new QNetworkAccessManager(this))
+    , m_clock(clock ? clock : ClockSource::system())
+    , m_updateTimer(m_clock->createTimer(this))
+    , m_network(network ? network : new NetworkClient(this))
     , m_timeString("--:--")
     , m_loading(false)
     , m_currentCountry("")
-    , m_localTimeTimer(new QTimer(this))
+    , m_localTimeTimer(m_clock->createTimer(this))
     , m_timezoneOffset(0)
 {
     initializeCountryData();
-
-    connect(m_networkManager, &QNetworkAccessManager::finished,
-            this, &TimeBackend::handleTimeReply);
+    rebuildGeoIndex();
 
     // API sync timer (every 5 minutes)
     m_updateTimer->setInterval(apiSyncMs());
-    connect(m_updateTimer, &QTimer::timeout, this, [this]() {
-        if (!m_currentCountry.isEmpty())
-            fetchTimeData(m_currentCountry);
+    connect(m_updateTimer, &ClockTimer::timeout, this, [this]() {
+        if (m_hasPosition)
+            fetchTimeDataAt(m_currentLat, m_currentLng);
     });
 
     // Local time timer (every 1 second)
     m_localTimeTimer->setInterval(localTickMs());
-    connect(m_localTimeTimer, &QTimer::timeout, this, &TimeBackend::updateLocalTime);
+    connect(m_localTimeTimer, &ClockTimer::timeout, this, &TimeBackend::updateLocalTime);
     m_localTimeTimer->start();
 }
 
 void TimeBackend::initializeCountryData()
 {
     m_countryCoordinates.clear();
+    m_countryCodes.clear();
+
+    addCountry("Afghanistan", "AF", {34.5553, 69.2075});
+    addCountry("Albania", "AL", {41.3275, 19.8187});
+    addCountry("Algeria", "DZ", {36.7538, 3.0588});
+    addCountry("Andorra", "AD", {42.5063, 1.5218});
+    addCountry("Angola", "AO", {-8.8383, 13.2344});
+    addCountry("Argentina", "AR", {-34.6037, -58.3816});
+    addCountry("Armenia", "AM", {40.1792, 44.4991});
+    addCountry("Australia", "AU", {-35.2809, 149.1300});
+    addCountry("Austria", "AT", {48.2082, 16.3738});
+    addCountry("Azerbaijan", "AZ", {40.4093, 49.8671});
+    addCountry("Bahamas", "BS", {25.0343, -77.3963});
+    addCountry("Bahrain", "BH", {26.2235, 50.5876});
+    addCountry("Bangladesh", "BD", {23.8103, 90.4125});
+    addCountry("Barbados", "BB", {13.1132, -59.5988});
+    addCountry("Belarus", "BY", {53.9045, 27.5615});
+    addCountry("Belgium", "BE", {50.8503, 4.3517});
+    addCountry("Belize", "BZ", {17.1899, -88.4976});
+    addCountry("Benin", "BJ", {6.4969, 2.6289});
+    addCountry("Bhutan", "BT", {27.4728, 89.6390});
+    addCountry("Bolivia", "BO", {-16.4897, -68.1193});
+    addCountry("Bosnia and Herzegovina", "BA", {43.8563, 18.4131});
+    addCountry("Botswana", "BW", {-24.6282, 25.9231});
+    addCountry("Brazil", "BR", {-15.8267, -47.9218});
+    addCountry("Brunei", "BN", {4.9031, 114.9398});
+    addCountry("Bulgaria", "BG", {42.6977, 23.3219});
+    addCountry("Burkina Faso", "BF", {12.3714, -1.5197});
+    addCountry("Burundi", "BI", {-3.3614, 29.3599});
+    addCountry("Cambodia", "KH", {11.5564, 104.9282});
+    addCountry("Cameroon", "CM", {3.8480, 11.5021});
+    addCountry("Canada", "CA", {45.4215, -75.6972});
+    addCountry("Cape Verde", "CV", {14.9330, -23.5133});
+    addCountry("Central African Republic", "CF", {4.3947, 18.5582});
+    addCountry("Chad", "TD", {12.1348, 15.0557});
+    addCountry("Chile", "CL", {-33.4489, -70.6693});
+    addCountry("China", "CN", {39.9042, 116.4074});
+    addCountry("Colombia", "CO", {4.7110, -74.0721});
+    addCountry("Comoros", "KM", {-11.7172, 43.2473});
+    addCountry("Congo", "CG", {-4.2634, 15.2429});
+    addCountry("Costa Rica", "CR", {9.9281, -84.0907});
+    addCountry("Croatia", "HR", {45.8150, 15.9819});
+    addCountry("Cuba", "CU", {23.1136, -82.3666});
+    addCountry("Cyprus", "CY", {35.1856, 33.3823});
+    addCountry("Czech Republic", "CZ", {50.0755, 14.4378});
+    addCountry("Denmark", "DK", {55.6761, 12.5683});
+    addCountry("Djibouti", "DJ", {11.5721, 43.1456});
+    addCountry("Dominica", "DM", {15.3092, -61.3794});
+    addCountry("Dominican Republic", "DO", {18.4861, -69.9312});
+    addCountry("East Timor", "TL", {-8.5569, 125.5603});
+    addCountry("Ecuador", "EC", {-0.1807, -78.4678});
+    addCountry("Egypt", "EG", {30.0444, 31.2357});
+    addCountry("El Salvador", "SV", {13.6929, -89.2182});
+    addCountry("Equatorial Guinea", "GQ", {3.7504, 8.7371});
+    addCountry("Eritrea", "ER", {15.3229, 38.9251});
+    addCountry("Estonia", "EE", {59.4370, 24.7536});
+    addCountry("Eswatini", "SZ", {-26.3051, 31.1367});
+    addCountry("Ethiopia", "ET", {9.0084, 38.7648});
+    addCountry("Fiji", "FJ", {-18.1248, 178.4501});
+    addCountry("Finland", "FI", {60.1699, 24.9384});
+    addCountry("France", "FR", {48.8566, 2.3522});
+    addCountry("Gabon", "GA", {0.4162, 9.4673});
+    addCountry("Gambia", "GM", {13.4549, -16.5790});
+    addCountry("Georgia", "GE", {41.7151, 44.8271});
+    addCountry("Germany", "DE", {52.5200, 13.4050});
+    addCountry("Ghana", "GH", {5.6037, -0.1870});
+    addCountry("Greece", "GR", {37.9838, 23.7275});
+    addCountry("Grenada", "GD", {12.0561, -61.7486});
+    addCountry("Guatemala", "GT", {14.6349, -90.5069});
+    addCountry("Guinea", "GN", {9.6412, -13.5784});
+    addCountry("Guinea-Bissau", "GW", {11.8636, -15.5846});
+    addCountry("Guyana", "GY", {6.8013, -58.1551});
+    addCountry("Haiti", "HT", {18.5944, -72.3074});
+    addCountry("Honduras", "HN", {14.0723, -87.1921});
+    addCountry("Hungary", "HU", {47.4979, 19.0402});
+    addCountry("Iceland", "IS", {64.1466, -21.9426});
+    addCountry("India", "IN", {28.6139, 77.2090});
+    addCountry("Indonesia", "ID", {-6.2088, 106.8456});
+    addCountry("Iran", "IR", {35.6892, 51.3890});
+    addCountry("Iraq", "IQ", {33.3152, 44.3661});
+    addCountry("Ireland", "IE", {53.3498, -6.2603});
+    addCountry("Israel", "IL", {31.7683, 35.2137});
+    addCountry("Italy", "IT", {41.9028, 12.4964});
+    addCountry("Ivory Coast", "CI", {5.3599, -4.0083});
+    addCountry("Jamaica", "JM", {18.0179, -76.8099});
+    addCountry("Japan", "JP", {35.6762, 139.6503});
+    addCountry("Jordan", "JO", {31.9454, 35.9284});
+    addCountry("Kazakhstan", "KZ", {51.1605, 71.4704});
+    addCountry("Kenya", "KE", {-1.2864, 36.8172});
+    addCountry("Kiribati", "KI", {1.4518, 172.9717});
+    addCountry("Korea North", "KP", {39.0392, 125.7625});
+    addCountry("Korea South", "KR", {37.5665, 126.9780});
+    addCountry("Kosovo", "XK", {42.6629, 21.1655});
+    addCountry("Kuwait", "KW", {29.3759, 47.9774});
+    addCountry("Kyrgyzstan", "KG", {42.8746, 74.5698});
+    addCountry("Laos", "LA", {17.9757, 102.6331});
+    addCountry("Latvia", "LV", {56.9496, 24.1052});
+    addCountry("Lebanon", "LB", {33.8938, 35.5018});
+    addCountry("Lesotho", "LS", {-29.3101, 27.4786});
+    addCountry("Liberia", "LR", {6.2907, -10.7605});
+    addCountry("Libya", "LY", {32.8872, 13.1913});
+    addCountry("Liechtenstein", "LI", {47.1410, 9.5209});
+    addCountry("Lithuania", "LT", {54.6872, 25.2797});
+    addCountry("Luxembourg", "LU", {49.6116, 6.1319});
+    addCountry("Madagascar", "MG", {-18.8792, 47.5079});
+    addCountry("Malawi", "MW", {-13.9626, 33.7741});
+    addCountry("Malaysia", "MY", {3.1390, 101.6869});
+    addCountry("Maldives", "MV", {4.1755, 73.5093});
+    addCountry("Mali", "ML", {12.6392, -8.0029});
+    addCountry("Malta", "MT", {35.8989, 14.5146});
+    addCountry("Marshall Islands", "MH", {7.0897, 171.3803});
+    addCountry("Mauritania", "MR", {18.0731, -15.9582});
+    addCountry("Mauritius", "MU", {-20.1609, 57.5012});
+    addCountry("Mexico", "MX", {19.4326, -99.1332});
+    addCountry("Micronesia", "FM", {6.9147, 158.1610});
+    addCountry("Moldova", "MD", {47.0105, 28.8638});
+    addCountry("Monaco", "MC", {43.7384, 7.4246});
+    addCountry("Mongolia", "MN", {47.8864, 106.9057});
+    addCountry("Montenegro", "ME", {42.4304, 19.2594});
+    addCountry("Morocco", "MA", {34.0209, -6.8416});
+    addCountry("Mozambique", "MZ", {-25.9692, 32.5732});
+    addCountry("Myanmar", "MM", {16.8409, 96.1735});
+    addCountry("Namibia", "NA", {-22.5609, 17.0658});
+    addCountry("Nauru", "NR", {-0.5228, 166.9315});
+    addCountry("Nepal", "NP", {27.7172, 85.3240});
+    addCountry("Netherlands", "NL", {52.3676, 4.9041});
+    addCountry("New Zealand", "NZ", {-41.2865, 174.7762});
+    addCountry("Nicaragua", "NI", {12.1364, -86.2514});
+    addCountry("Niger", "NE", {13.5127, 2.1126});
+    addCountry("Nigeria", "NG", {9.0579, 7.4951});
+    addCountry("North Macedonia", "MK", {42.0080, 21.4294});
+    addCountry("Norway", "NO", {59.9139, 10.7522});
+    addCountry("Oman", "OM", {23.5859, 58.4059});
+    addCountry("Pakistan", "PK", {33.6844, 73.0479});
+    addCountry("Palau", "PW", {7.5149, 134.5825});
+    addCountry("Panama", "PA", {8.9824, -79.5199});
+    addCountry("Papua New Guinea", "PG", {-9.4438, 147.1803});
+    addCountry("Paraguay", "PY", {-25.2637, -57.5759});
+    addCountry("Peru", "PE", {-12.0464, -77.0428});
+    addCountry("Philippines", "PH", {14.5995, 120.9842});
+    addCountry("Poland", "PL", {52.2297, 21.0122});
+    addCountry("Portugal", "PT", {38.7223, -9.1393});
+    addCountry("Qatar", "QA", {25.2769, 51.5200});
+    addCountry("Romania", "RO", {44.4268, 26.1025});
+    addCountry("Russia", "RU", {55.7558, 37.6173});
+    addCountry("Rwanda", "RW", {-1.9501, 30.0588});
+    addCountry("Saint Kitts and Nevis", "KN", {17.3578, -62.7830});
+    addCountry("Saint Lucia", "LC", {14.0101, -60.9875});
+    addCountry("Saint Vincent and the Grenadines", "VC", {13.1600, -61.2248});
+    addCountry("Samoa", "WS", {-13.7590, -172.1046});
+    addCountry("San Marino", "SM", {43.9424, 12.4578});
+    addCountry("Sao Tome and Principe", "ST", {0.3302, 6.7333});
+    addCountry("Saudi Arabia", "SA", {24.7136, 46.6753});
+    addCountry("Senegal", "SN", {14.7167, -17.4677});
+    addCountry("Serbia", "RS", {44.7866, 20.4489});
+    addCountry("Seychelles", "SC", {-4.6796, 55.4920});
+    addCountry("Sierra Leone", "SL", {8.4840, -13.2297});
+    addCountry("Singapore", "SG", {1.3521, 103.8198});
+    addCountry("Slovakia", "SK", {48.1486, 17.1077});
+    addCountry("Slovenia", "SI", {46.0569, 14.5058});
+    addCountry("Solomon Islands", "SB", {-9.4456, 159.9729});
+    addCountry("Somalia", "SO", {2.0469, 45.3182});
+    addCountry("South Africa", "ZA", {-25.7479, 28.2293});
+    addCountry("South Sudan", "SS", {4.8594, 31.5713});
+    addCountry("Spain", "ES", {40.4168, -3.7038});
+    addCountry("Sri Lanka", "LK", {6.9271, 79.8612});
+    addCountry("Sudan", "SD", {15.5007, 32.5599});
+    addCountry("Suriname", "SR", {5.8520, -55.2038});
+    addCountry("Sweden", "SE", {59.3293, 18.0686});
+    addCountry("Switzerland", "CH", {46.9480, 7.4474});
+    addCountry("Syria", "SY", {33.5138, 36.2765});
+    addCountry("Taiwan", "TW", {25.0330, 121.5654});
+    addCountry("Tajikistan", "TJ", {38.5598, 68.7870});
+    addCountry("Tanzania", "TZ", {-6.1630, 35.7516});
+    addCountry("Thailand", "TH", {13.7563, 100.5018});
+    addCountry("Togo", "TG", {6.1725, 1.2314});
+    addCountry("Tonga", "TO", {-21.1393, -175.2049});
+    addCountry("Trinidad and Tobago", "TT", {10.6918, -61.2225});
+    addCountry("Tunisia", "TN", {36.8065, 10.1815});
+    addCountry("Turkey", "TR", {39.9334, 32.8597});
+    addCountry("Turkmenistan", "TM", {37.9601, 58.3261});
+    addCountry("Tuvalu", "TV", {-8.5167, 179.2166});
+    addCountry("Uganda", "UG", {0.3136, 32.5811});
+    addCountry("Ukraine", "UA", {50.4501, 30.5234});
+    addCountry("United Arab Emirates", "AE", {24.4539, 54.3773});
+    addCountry("United Kingdom", "GB", {51.5074, -0.1278});
+    addCountry("United States", "US", {38.9072, -77.0369});
+    addCountry("Uruguay", "UY", {-34.9011, -56.1645});
+    addCountry("Uzbekistan", "UZ", {41.2995, 69.2401});
+    addCountry("Vanuatu", "VU", {-17.7333, 168.3273});
+    addCountry("Vatican City", "VA", {41.9029, 12.4534});
+    addCountry("Venezuela", "VE", {10.4806, -66.9036});
+    addCountry("Vietnam", "VN", {21.0278, 105.8342});
+    addCountry("Yemen", "YE", {15.3694, 44.1910});
+    addCountry("Zambia", "ZM", {-15.3875, 28.3228});
+    addCountry("Zimbabwe", "ZW", {-17.8292, 31.0522});
+}
 
-    m_countryCoordinates.insert("Afghanistan", {"34.5553", "69.2075"});
-    m_countryCoordinates.insert("Albania", {"41.3275", "19.8187"});
-    m_countryCoordinates.insert("Algeria", {"36.7538", "3.0588"});
-    m_countryCoordinates.insert("Andorra", {"42.5063", "1.5218"});
-    m_countryCoordinates.insert("Angola", {"-8.8383", "13.2344"});
-    m_countryCoordinates.insert("Argentina", {"-34.6037", "-58.3816"});
-    m_countryCoordinates.insert("Armenia", {"40.1792", "44.4991"});
-    m_countryCoordinates.insert("Australia", {"-35.2809", "149.1300"});
-    m_countryCoordinates.insert("Austria", {"48.2082", "16.3738"});
-    m_countryCoordinates.insert("Azerbaijan", {"40.4093", "49.8671"});
-    m_countryCoordinates.insert("Bahamas", {"25.0343", "-77.3963"});
-    m_countryCoordinates.insert("Bahrain", {"26.2235", "50.5876"});
-    m_countryCoordinates.insert("Bangladesh", {"23.8103", "90.4125"});
-    m_countryCoordinates.insert("Barbados", {"13.1132", "-59.5988"});
-    m_countryCoordinates.insert("Belarus", {"53.9045", "27.5615"});
-    m_countryCoordinates.insert("Belgium", {"50.8503", "4.3517"});
-    m_countryCoordinates.insert("Belize", {"17.1899", "-88.4976"});
-    m_countryCoordinates.insert("Benin", {"6.4969", "2.6289"});
-    m_countryCoordinates.insert("Bhutan", {"27.4728", "89.6390"});
-    m_countryCoordinates.insert("Bolivia", {"-16.4897", "-68.1193"});
-    m_countryCoordinates.insert("Bosnia and Herzegovina", {"43.8563", "18.4131"});
-    m_countryCoordinates.insert("Botswana", {"-24.6282", "25.9231"});
-    m_countryCoordinates.insert("Brazil", {"-15.8267", "-47.9218"});
-    m_countryCoordinates.insert("Brunei", {"4.9031", "114.9398"});
-    m_countryCoordinates.insert("Bulgaria", {"42.6977", "23.3219"});
-    m_countryCoordinates.insert("Burkina Faso", {"12.3714", "-1.5197"});
-    m_countryCoordinates.insert("Burundi", {"-3.3614", "29.3599"});
-    m_countryCoordinates.insert("Cambodia", {"11.5564", "104.9282"});
-    m_countryCoordinates.insert("Cameroon", {"3.8480", "11.5021"});
-    m_countryCoordinates.insert("Canada", {"45.4215", "-75.6972"});
-    m_countryCoordinates.insert("Cape Verde", {"14.9330", "-23.5133"});
-    m_countryCoordinates.insert("Central African Republic", {"4.3947", "18.5582"});
-    m_countryCoordinates.insert("Chad", {"12.1348", "15.0557"});
-    m_countryCoordinates.insert("Chile", {"-33.4489", "-70.6693"});
-    m_countryCoordinates.insert("China", {"39.9042", "116.4074"});
-    m_countryCoordinates.insert("Colombia", {"4.7110", "-74.0721"});
-    m_countryCoordinates.insert("Comoros", {"-11.7172", "43.2473"});
-    m_countryCoordinates.insert("Congo", {"-4.2634", "15.2429"});
-    m_countryCoordinates.insert("Costa Rica", {"9.9281", "-84.0907"});
-    m_countryCoordinates.insert("Croatia", {"45.8150", "15.9819"});
-    m_countryCoordinates.insert("Cuba", {"23.1136", "-82.3666"});
-    m_countryCoordinates.insert("Cyprus", {"35.1856", "33.3823"});
-    m_countryCoordinates.insert("Czech Republic", {"50.0755", "14.4378"});
-    m_countryCoordinates.insert("Denmark", {"55.6761", "12.5683"});
-    m_countryCoordinates.insert("Djibouti", {"11.5721", "43.1456"});
-    m_countryCoordinates.insert("Dominica", {"15.3092", "-61.3794"});
-    m_countryCoordinates.insert("Dominican Republic", {"18.4861", "-69.9312"});
-    m_countryCoordinates.insert("East Timor", {"-8.5569", "125.5603"});
-    m_countryCoordinates.insert("Ecuador", {"-0.1807", "-78.4678"});
-    m_countryCoordinates.insert("Egypt", {"30.0444", "31.2357"});
-    m_countryCoordinates.insert("El Salvador", {"13.6929", "-89.2182"});
-    m_countryCoordinates.insert("Equatorial Guinea", {"3.7504", "8.7371"});
-    m_countryCoordinates.insert("Eritrea", {"15.3229", "38.9251"});
-    m_countryCoordinates.insert("Estonia", {"59.4370", "24.7536"});
-    m_countryCoordinates.insert("Eswatini", {"-26.3051", "31.1367"});
-    m_countryCoordinates.insert("Ethiopia", {"9.0084", "38.7648"});
-    m_countryCoordinates.insert("Fiji", {"-18.1248", "178.4501"});
-    m_countryCoordinates.insert("Finland", {"60.1699", "24.9384"});
-    m_countryCoordinates.insert("France", {"48.8566", "2.3522"});
-    m_countryCoordinates.insert("Gabon", {"0.4162", "9.4673"});
-    m_countryCoordinates.insert("Gambia", {"13.4549", "-16.5790"});
-    m_countryCoordinates.insert("Georgia", {"41.7151", "44.8271"});
-    m_countryCoordinates.insert("Germany", {"52.5200", "13.4050"});
-    m_countryCoordinates.insert("Ghana", {"5.6037", "-0.1870"});
-    m_countryCoordinates.insert("Greece", {"37.9838", "23.7275"});
-    m_countryCoordinates.insert("Grenada", {"12.0561", "-61.7486"});
-    m_countryCoordinates.insert("Guatemala", {"14.6349", "-90.5069"});
-    m_countryCoordinates.insert("Guinea", {"9.6412", "-13.5784"});
-    m_countryCoordinates.insert("Guinea-Bissau", {"11.8636", "-15.5846"});
-    m_countryCoordinates.insert("Guyana", {"6.8013", "-58.1551"});
-    m_countryCoordinates.insert("Haiti", {"18.5944", "-72.3074"});
-    m_countryCoordinates.insert("Honduras", {"14.0723", "-87.1921"});
-    m_countryCoordinates.insert("Hungary", {"47.4979", "19.0402"});
-    m_countryCoordinates.insert("Iceland", {"64.1466", "-21.9426"});
-    m_countryCoordinates.insert("India", {"28.6139", "77.2090"});
-    m_countryCoordinates.insert("Indonesia", {"-6.2088", "106.8456"});
-    m_countryCoordinates.insert("Iran", {"35.6892", "51.3890"});
-    m_countryCoordinates.insert("Iraq", {"33.3152", "44.3661"});
-    m_countryCoordinates.insert("Ireland", {"53.3498", "-6.2603"});
-    m_countryCoordinates.insert("Israel", {"31.7683", "35.2137"});
-    m_countryCoordinates.insert("Italy", {"41.9028", "12.4964"});
-    m_countryCoordinates.insert("Ivory Coast", {"5.3599", "-4.0083"});
-    m_countryCoordinates.insert("Jamaica", {"18.0179", "-76.8099"});
-    m_countryCoordinates.insert("Japan", {"35.6762", "139.6503"});
-    m_countryCoordinates.insert("Jordan", {"31.9454", "35.9284"});
-    m_countryCoordinates.insert("Kazakhstan", {"51.1605", "71.4704"});
-    m_countryCoordinates.insert("Kenya", {"-1.2864", "36.8172"});
-    m_countryCoordinates.insert("Kiribati", {"1.4518", "172.9717"});
-    m_countryCoordinates.insert("Korea North", {"39.0392", "125.7625"});
-    m_countryCoordinates.insert("Korea South", {"37.5665", "126.9780"});
-    m_countryCoordinates.insert("Kosovo", {"42.6629", "21.1655"});
-    m_countryCoordinates.insert("Kuwait", {"29.3759", "47.9774"});
-    m_countryCoordinates.insert("Kyrgyzstan", {"42.8746", "74.5698"});
-    m_countryCoordinates.insert("Laos", {"17.9757", "102.6331"});
-    m_countryCoordinates.insert("Latvia", {"56.9496", "24.1052"});
-    m_countryCoordinates.insert("Lebanon", {"33.8938", "35.5018"});
-    m_countryCoordinates.insert("Lesotho", {"-29.3101", "27.4786"});
-    m_countryCoordinates.insert("Liberia", {"6.2907", "-10.7605"});
-    m_countryCoordinates.insert("Libya", {"32.8872", "13.1913"});
-    m_countryCoordinates.insert("Liechtenstein", {"47.1410", "9.5209"});
-    m_countryCoordinates.insert("Lithuania", {"54.6872", "25.2797"});
-    m_countryCoordinates.insert("Luxembourg", {"49.6116", "6.1319"});
-    m_countryCoordinates.insert("Madagascar", {"-18.8792", "47.5079"});
-    m_countryCoordinates.insert("Malawi", {"-13.9626", "33.7741"});
-    m_countryCoordinates.insert("Malaysia", {"3.1390", "101.6869"});
-    m_countryCoordinates.insert("Maldives", {"4.1755", "73.5093"});
-    m_countryCoordinates.insert("Mali", {"12.6392", "-8.0029"});
-    m_countryCoordinates.insert("Malta", {"35.8989", "14.5146"});
-    m_countryCoordinates.insert("Marshall Islands", {"7.0897", "171.3803"});
-    m_countryCoordinates.insert("Mauritania", {"18.0731", "-15.9582"});
-    m_countryCoordinates.insert("Mauritius", {"-20.1609", "57.5012"});
-    m_countryCoordinates.insert("Mexico", {"19.4326", "-99.1332"});
-    m_countryCoordinates.insert("Micronesia", {"6.9147", "158.1610"});
-    m_countryCoordinates.insert("Moldova", {"47.0105", "28.8638"});
-    m_countryCoordinates.insert("Monaco", {"43.7384", "7.4246"});
-    m_countryCoordinates.insert("Mongolia", {"47.8864", "106.9057"});
-    m_countryCoordinates.insert("Montenegro", {"42.4304", "19.2594"});
-    m_countryCoordinates.insert("Morocco", {"34.0209", "-6.8416"});
-    m_countryCoordinates.insert("Mozambique", {"-25.9692", "32.5732"});
-    m_countryCoordinates.insert("Myanmar", {"16.8409", "96.1735"});
-    m_countryCoordinates.insert("Namibia", {"-22.5609", "17.0658"});
-    m_countryCoordinates.insert("Nauru", {"-0.5228", "166.9315"});
-    m_countryCoordinates.insert("Nepal", {"27.7172", "85.3240"});
-    m_countryCoordinates.insert("Netherlands", {"52.3676", "4.9041"});
-    m_countryCoordinates.insert("New Zealand", {"-41.2865", "174.7762"});
-    m_countryCoordinates.insert("Nicaragua", {"12.1364", "-86.2514"});
-    m_countryCoordinates.insert("Niger", {"13.5127", "2.1126"});
-    m_countryCoordinates.insert("Nigeria", {"9.0579", "7.4951"});
-    m_countryCoordinates.insert("North Macedonia", {"42.0080", "21.4294"});
-    m_countryCoordinates.insert("Norway", {"59.9139", "10.7522"});
-    m_countryCoordinates.insert("Oman", {"23.5859", "58.4059"});
-    m_countryCoordinates.insert("Pakistan", {"33.6844", "73.0479"});
-    m_countryCoordinates.insert("Palau", {"7.5149", "134.5825"});
-    m_countryCoordinates.insert("Panama", {"8.9824", "-79.5199"});
-    m_countryCoordinates.insert("Papua New Guinea", {"-9.4438", "147.1803"});
-    m_countryCoordinates.insert("Paraguay", {"-25.2637", "-57.5759"});
-    m_countryCoordinates.insert("Peru", {"-12.0464", "-77.0428"});
-    m_countryCoordinates.insert("Philippines", {"14.5995", "120.9842"});
-    m_countryCoordinates.insert("Poland", {"52.2297", "21.0122"});
-    m_countryCoordinates.insert("Portugal", {"38.7223", "-9.1393"});
-    m_countryCoordinates.insert("Qatar", {"25.2769", "51.5200"});
-    m_countryCoordinates.insert("Romania", {"44.4268", "26.1025"});
-    m_countryCoordinates.insert("Russia", {"55.7558", "37.6173"});
-    m_countryCoordinates.insert("Rwanda", {"-1.9501", "30.0588"});
-    m_countryCoordinates.insert("Saint Kitts and Nevis", {"17.3578", "-62.7830"});
-    m_countryCoordinates.insert("Saint Lucia", {"14.0101", "-60.9875"});
-    m_countryCoordinates.insert("Saint Vincent and the Grenadines", {"13.1600", "-61.2248"});
-    m_countryCoordinates.insert("Samoa", {"-13.7590", "-172.1046"});
-    m_countryCoordinates.insert("San Marino", {"43.9424", "12.4578"});
-    m_countryCoordinates.insert("Sao Tome and Principe", {"0.3302", "6.7333"});
-    m_countryCoordinates.insert("Saudi Arabia", {"24.7136", "46.6753"});
-    m_countryCoordinates.insert("Senegal", {"14.7167", "-17.4677"});
-    m_countryCoordinates.insert("Serbia", {"44.7866", "20.4489"});
-    m_countryCoordinates.insert("Seychelles", {"-4.6796", "55.4920"});
-    m_countryCoordinates.insert("Sierra Leone", {"8.4840", "-13.2297"});
-    m_countryCoordinates.insert("Singapore", {"1.3521", "103.8198"});
-    m_countryCoordinates.insert("Slovakia", {"48.1486", "17.1077"});
-    m_countryCoordinates.insert("Slovenia", {"46.0569", "14.5058"});
-    m_countryCoordinates.insert("Solomon Islands", {"-9.4456", "159.9729"});
-    m_countryCoordinates.insert("Somalia", {"2.0469", "45.3182"});
-    m_countryCoordinates.insert("South Africa", {"-25.7479", "28.2293"});
-    m_countryCoordinates.insert("South Sudan", {"4.8594", "31.5713"});
-    m_countryCoordinates.insert("Spain", {"40.4168", "-3.7038"});
-    m_countryCoordinates.insert("Sri Lanka", {"6.9271", "79.8612"});
-    m_countryCoordinates.insert("Sudan", {"15.5007", "32.5599"});
-    m_countryCoordinates.insert("Suriname", {"5.8520", "-55.2038"});
-    m_countryCoordinates.insert("Sweden", {"59.3293", "18.0686"});
-    m_countryCoordinates.insert("Switzerland", {"46.9480", "7.4474"});
-    m_countryCoordinates.insert("Syria", {"33.5138", "36.2765"});
-    m_countryCoordinates.insert("Taiwan", {"25.0330", "121.5654"});
-    m_countryCoordinates.insert("Tajikistan", {"38.5598", "68.7870"});
-    m_countryCoordinates.insert("Tanzania", {"-6.1630", "35.7516"});
-    m_countryCoordinates.insert("Thailand", {"13.7563", "100.5018"});
-    m_countryCoordinates.insert("Togo", {"6.1725", "1.2314"});
-    m_countryCoordinates.insert("Tonga", {"-21.1393", "-175.2049"});
-    m_countryCoordinates.insert("Trinidad and Tobago", {"10.6918", "-61.2225"});
-    m_countryCoordinates.insert("Tunisia", {"36.8065", "10.1815"});
-    m_countryCoordinates.insert("Turkey", {"39.9334", "32.8597"});
-    m_countryCoordinates.insert("Turkmenistan", {"37.9601", "58.3261"});
-    m_countryCoordinates.insert("Tuvalu", {"-8.5167", "179.2166"});
-    m_countryCoordinates.insert("Uganda", {"0.3136", "32.5811"});
-    m_countryCoordinates.insert("Ukraine", {"50.4501", "30.5234"});
-    m_countryCoordinates.insert("United Arab Emirates", {"24.4539", "54.3773"});
-    m_countryCoordinates.insert("United Kingdom", {"51.5074", "-0.1278"});
-    m_countryCoordinates.insert("United States", {"38.9072", "-77.0369"});
-    m_countryCoordinates.insert("Uruguay", {"-34.9011", "-56.1645"});
-    m_countryCoordinates.insert("Uzbekistan", {"41.2995", "69.2401"});
-    m_countryCoordinates.insert("Vanuatu", {"-17.7333", "168.3273"});
-    m_countryCoordinates.insert("Vatican City", {"41.9029", "12.4534"});
-    m_countryCoordinates.insert("Venezuela", {"10.4806", "-66.9036"});
-    m_countryCoordinates.insert("Vietnam", {"21.0278", "105.8342"});
-    m_countryCoordinates.insert("Yemen", {"15.3694", "44.1910"});
-    m_countryCoordinates.insert("Zambia", {"-15.3875", "28.3228"});
-    m_countryCoordinates.insert("Zimbabwe", {"-17.8292", "31.0522"});
+void TimeBackend::addCountry(const QString &name, const QString &code, GeoPoint capital)
+{
+    m_countryCoordinates.insert(name, capital);
+    m_countryCodes.insert(name, code);
 }
 
 QVariantMap TimeBackend::getCoordinates(const QString &country)
 {
+    ALLOC_PHASE(Lookup);
     QVariantMap result;
 
-    if (!m_countryCoordinates.contains(country)) {
+    const auto it = m_countryCoordinates.constFind(country);
+    if (it == m_countryCoordinates.constEnd()) {
+        result["success"] = false;
         result["error"] = "Country not found";
         return result;
     }
 
-    if (m_countryCoordinates.contains(country)) {
-        auto coords = m_countryCoordinates[country];
-        result["lat"] = coords.first;
-        result["lng"] = coords.second;
-        result["success"] = true;
+    result["lat"] = it->lat;
+    result["lng"] = it->lng;
+    result["success"] = true;
+    return result;
+}
+
+void TimeBackend::setCityIndex(const CityIndex *index)
+{
+    m_cityIndex = index;
+    rebuildGeoIndex();
+}
+
+void TimeBackend::rebuildGeoIndex()
+{
+    m_geoCountries.clear();
+    m_geoCityEntries.clear();
+
+    // A city index lists most capitals again under the city's own name and
+    // with its own coordinates. For each capital, drop the most populous
+    // city of the same country within kDuplicateKm so lookups do not
+    // return the same place twice; names cannot be compared since the
+    // capitals are keyed by country.
+    QVector<GeoPoint> cityPoints;
+    QVector<bool> isCapital;
+    if (m_cityIndex) {
+        cityPoints.reserve(m_cityIndex->size());
+        for (int i = 0; i < m_cityIndex->size(); ++i)
+            cityPoints.append({m_cityIndex->latitude(i), m_cityIndex->longitude(i)});
+        isCapital.fill(false, cityPoints.size());
+        m_geoIndex.build(cityPoints);
+    }
+
+    QVector<GeoPoint> points;
+    for (auto it = m_countryCoordinates.cbegin(); it != m_countryCoordinates.cend(); ++it) {
+        m_geoCountries.append(it.key());
+        points.append(it.value());
+        if (!m_cityIndex)
+            continue;
+
+        const QString code = m_countryCodes.value(it.key());
+        int match = -1;
+        for (const GeoIndex::Hit &hit : m_geoIndex.withinRadius(it->lat, it->lng, kDuplicateKm)) {
+            // Hits come nearest first, so equal populations keep the nearest.
+            if (m_cityIndex->country(hit.id) == code
+                && (match < 0 || m_cityIndex->population(hit.id) > m_cityIndex->population(match)))
+                match = hit.id;
+        }
+        if (match >= 0)
+            isCapital[match] = true;
+    }
+
+    for (int i = 0; i < cityPoints.size(); ++i) {
+        if (isCapital[i])
+            continue;
+        m_geoCityEntries.append(i);
+        points.append(cityPoints[i]);
+    }
+
+    m_geoIndex.build(points);
+}
+
+QVariantMap TimeBackend::geoHitToMap(const GeoIndex::Hit &hit) const
+{
+    QVariantMap result;
+    if (hit.id < m_geoCountries.size()) {
+        const QString &country = m_geoCountries.at(hit.id);
+        const GeoPoint point = m_countryCoordinates.value(country);
+        result["name"] = country;
+        result["country"] = m_countryCodes.value(country);
+        result["lat"] = point.lat;
+        result["lng"] = point.lng;
     } else {
-        result["success"] = false;
-        result["error"] = "Country coordinates not available";
+        const int entry = m_geoCityEntries.at(hit.id - m_geoCountries.size());
+        result["name"] = m_cityIndex->name(entry);
+        result["country"] = m_cityIndex->country(entry);
+        result["lat"] = m_cityIndex->latitude(entry);
+        result["lng"] = m_cityIndex->longitude(entry);
     }
+    result["distanceKm"] = hit.distanceKm;
+    return result;
+}
+
+QVariantList TimeBackend::nearestLocations(double lat, double lng, int k) const
+{
+    ALLOC_PHASE(Lookup);
+    QVariantList result;
+    const QVector<GeoIndex::Hit> hits = m_geoIndex.nearest(lat, lng, k);
+    result.reserve(hits.size());
+    for (const GeoIndex::Hit &hit : hits)
+        result.append(geoHitToMap(hit));
+    return result;
+}
 
+QVariantList TimeBackend::locationsWithinRadius(double lat, double lng, double radiusKm) const
+{
+    ALLOC_PHASE(Lookup);
+    QVariantList result;
+    const QVector<GeoIndex::Hit> hits = m_geoIndex.withinRadius(lat, lng, radiusKm);
+    result.reserve(hits.size());
+    for (const GeoIndex::Hit &hit : hits)
+        result.append(geoHitToMap(hit));
     return result;
 }
 
@@ -287,13 +394,20 @@ void TimeBackend::stopAutoUpdate()
 
 void TimeBackend::updateLocalTime()
 {
+    ALLOC_PHASE(ClockTick);
     if (!m_lastApiTime.isValid())
         return;
 
     // Calculate current time in target timezone
-    QDateTime now = QDateTime::currentDateTimeUtc().addSecs(m_timezoneOffset);
+    QDateTime now = m_clock->currentDateTimeUtc().addSecs(m_timezoneOffset);
     m_timeString = now.toString(timeFmt());
-    emit timeUpdated();
+
+    // Attributed separately so a tick's own budget is not charged for
+    // whatever the bindings on timeString allocate.
+    {
+        ALLOC_PHASE(Publish);
+        emit timeUpdated();
+    }
 }
 
 void TimeBackend::fetchTimeData(const QString &country)
@@ -307,21 +421,81 @@ void TimeBackend::fetchTimeData(const QString &country)
         return;
     }
 
-    QVariantMap coords = getCoordinates(country);
-    if (!coords["success"].toBool()) {
-        emit errorOccurred(coords["error"].toString());
+    const auto it = m_countryCoordinates.constFind(country);
+    if (it == m_countryCoordinates.constEnd()) {
+        emit errorOccurred("Country not found");
+        return;
+    }
+
+    fetchTimeDataAt(it->lat, it->lng);
+}
+
+QString TimeBackend::requestUrl(double lat, double lng) const
+{
+    return QStringLiteral("%1?key=%2&format=json&by=position&lat=%3&lng=%4")
+        .arg(timeApiBase(), timeApiKey(),
+             QString::number(lat, 'f', 4),
+             QString::number(lng, 'f', 4));
+}
+
+void TimeBackend::fetchTimeDataAt(double lat, double lng)
+{
+    ALLOC_PHASE(RequestBuild);
+    if (!m_hasPosition || lat != m_currentLat || lng != m_currentLng)
+        setPosition(lat, lng);
+
+    if (timeApiKey().isEmpty()) {
+        emit errorOccurred("Set TIME_API_KEY");
         return;
     }
 
     m_loading = true;
     emit loadingChanged();
 
-    const QString url = QStringLiteral("%1?key=%2&format=json&by=position&lat=%3&lng=%4")
-                            .arg(timeApiBase(), timeApiKey(),
-                                 coords["lat"].toString(),
-                                 coords["lng"].toString());
+    QNetworkReply *reply = m_network->get(QUrl(requestUrl(lat, lng)));
+    const quint64 generation = m_positionGeneration;
+    connect(reply, &QNetworkReply::finished, this, [this, reply, lat, lng, generation]() {
+        handleTimeReply(reply, lat, lng, generation);
+    });
+}
 
-    m_networkManager->get(QNetworkRequest(QUrl(url)));
+QFuture<TimeReport> TimeBackend::requestTime(double lat, double lng)
+{
+    ALLOC_PHASE(RequestBuild);
+    auto promise = std::make_shared<QPromise<TimeReport>>();
+    promise->start();
+    QFuture<TimeReport> future = promise->future();
+
+    if (timeApiKey().isEmpty()) {
+        TimeReport report;
+        report.error = QStringLiteral("Set TIME_API_KEY");
+        promise->addResult(report);
+        promise->finish();
+        return future;
+    }
+
+    QNetworkReply *reply = m_network->get(QUrl(requestUrl(lat, lng)));
+
+    // Canceling the future aborts the request; the watcher goes with the reply.
+    auto *watcher = new QFutureWatcher<TimeReport>(reply);
+    connect(watcher, &QFutureWatcherBase::canceled, reply, &QNetworkReply::abort);
+    watcher->setFuture(future);
+
+    connect(reply, &QNetworkReply::finished, this, [reply, promise, lat, lng]() {
+        TimeReport report;
+        const QString error = NetworkClient::errorString(reply);
+        if (!error.isEmpty())
+            report.error = error;
+        else
+            report = parseTimeReport(NetworkClient::body(reply));
+        reply->deleteLater();
+
+        report.lat = lat;
+        report.lng = lng;
+        promise->addResult(report);
+        promise->finish();
+    });
+    return future;
 }
 
 void TimeBackend::startAutoUpdate(int intervalSeconds)
@@ -329,53 +503,110 @@ void TimeBackend::startAutoUpdate(int intervalSeconds)
     m_updateTimer->setInterval(intervalSeconds * 1000);
     m_updateTimer->start();
 
-    if (!m_currentCountry.isEmpty())
-        fetchTimeData(m_currentCountry); // Fetch immediately
+    if (m_hasPosition)
+        fetchTimeDataAt(m_currentLat, m_currentLng); // Fetch immediately
 }
 
-void TimeBackend::handleTimeReply(QNetworkReply *reply)
+void TimeBackend::handleTimeReply(QNetworkReply *reply, double lat, double lng, quint64 generation)
 {
-    m_loading = false;
-    emit loadingChanged();
-
     if (!reply) {
+        m_loading = false;
+        emit loadingChanged();
         emit errorOccurred("Null reply received");
         return;
     }
 
-    if (reply->error() != QNetworkReply::NoError) {
-        qDebug() << "Time API Error:" << reply->errorString();
+    // The position moved on, through a newer fetch or a LocationController
+    // snapshot, while this request was in flight. loading belongs to the
+    // newer fetch, if any; setPosition() already cleared it otherwise.
+    if (generation != m_positionGeneration || lat != m_currentLat || lng != m_currentLng) {
+        reply->deleteLater();
+        return;
+    }
+
+    m_loading = false;
+    emit loadingChanged();
+
+    const QString error = NetworkClient::errorString(reply);
+    if (!error.isEmpty()) {
+        emit errorOccurred(error);
         reply->deleteLater();
         return;
     }
 
-    parseTimeResponse(reply->readAll());
+    TimeReport report = parseTimeReport(NetworkClient::body(reply));
     reply->deleteLater();
+
+    if (!report.error.isEmpty()) {
+        emit errorOccurred(report.error);
+        return;
+    }
+
+    report.lat = lat;
+    report.lng = lng;
+    if (report.apiTime.isValid())
+        applyReport(report);
 }
 
-void TimeBackend::parseTimeResponse(const QByteArray &data)
+TimeReport TimeBackend::parseTimeReport(const QByteArray &data)
 {
+    ALLOC_PHASE(Parse);
+    TimeReport report;
     QJsonParseError parseError;
     QJsonDocument doc = QJsonDocument::fromJson(data, &parseError);
 
     if (parseError.error != QJsonParseError::NoError) {
-        emit errorOccurred("Failed to parse time data");
-        return;
+        report.error = QStringLiteral("Failed to parse time data");
+        return report;
     }
 
     QJsonObject json = doc.object();
     if (json.contains("formatted") && json.contains("gmtOffset") && json.contains("zoneName")) {
-        QString timeString = json["formatted"].toString();
-        m_timezoneOffset = json["gmtOffset"].toInt();
-        m_timezoneName = json["zoneName"].toString();
+        report.gmtOffset = json["gmtOffset"].toInt();
+        report.zoneName = json["zoneName"].toString();
 
         // Parse the API time and store it
-        m_lastApiTime = QDateTime::fromString(timeString, Qt::ISODate);
-        if (m_lastApiTime.isValid()) {
-            m_timeString = m_lastApiTime.toString(timeFmt());
-            emit timeUpdated();
-        }
+        report.apiTime = QDateTime::fromString(json["formatted"].toString(), Qt::ISODate);
     }
+
+    return report;
+}
+
+void TimeBackend::publishReport(const TimeReport &report)
+{
+    setPosition(report.lat, report.lng);
+    applyReport(report);
+}
+
+void TimeBackend::setPosition(double lat, double lng)
+{
+    m_hasPosition = true;
+    m_currentLat = lat;
+    m_currentLng = lng;
+    ++m_positionGeneration;
+
+    // Replies in flight for the previous position are dropped unseen.
+    if (m_loading) {
+        m_loading = false;
+        emit loadingChanged();
+    }
+}
+
+void TimeBackend::applyReport(const TimeReport &report)
+{
+    ALLOC_PHASE(Publish);
+    m_timezoneOffset = report.gmtOffset;
+    m_timezoneName = report.zoneName;
+    m_lastApiTime = report.apiTime;
+    m_timeString = m_lastApiTime.toString(timeFmt());
+    emit timeUpdated();
+}
+
+void TimeBackend::clearTime()
+{
+    m_lastApiTime = QDateTime();
+    m_timeString = QStringLiteral("--:--");
+    emit timeUpdated();
 }
 
 QString TimeBackend::timeString() const
@@ -390,5 +621,4 @@ bool TimeBackend::loading() const
 
 TimeBackend::~TimeBackend()
 {
-    delete m_networkManager;
 }
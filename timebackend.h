@@ -2,11 +2,27 @@
 #define TIMEBACKEND_H
 
 #include <QObject>
-#include <QNetworkAccessManager>
+#include <QFuture>
 #include <QNetworkReply>
 #include <QMap>
-#include <QPair>
-#include <QTimer>
+#include <QStringList>
+#include <QVariantList>
+#include "cityindex.h"
+#include "clocksource.h"
+#include "geoindex.h"
+#include "networkclient.h"
+
+// One parsed time zone response. apiTime is invalid when the response
+// lacked the expected fields; error is set when the request or parse failed.
+struct TimeReport
+{
+    double lat = 0.0;
+    double lng = 0.0;
+    int gmtOffset = 0;
+    QString zoneName;
+    QDateTime apiTime;
+    QString error;
+};
 
 class TimeBackend : public QObject
 {
@@ -15,15 +31,31 @@ class TimeBackend : public QObject
     Q_PROPERTY(bool loading READ loading NOTIFY loadingChanged)
 
 public:
-    explicit TimeBackend(QObject *parent = nullptr);
+    explicit TimeBackend(NetworkClient *network = nullptr, ClockSource *clock = nullptr,
+                         QObject *parent = nullptr);
     ~TimeBackend();
 
     QString timeString() const;
     bool loading() const;
     Q_INVOKABLE QVariantMap getCoordinates(const QString &country);
+    Q_INVOKABLE QVariantList nearestLocations(double lat, double lng, int k = 1) const;
+    Q_INVOKABLE QVariantList locationsWithinRadius(double lat, double lng, double radiusKm) const;
+
+    void setCityIndex(const CityIndex *index);
+
+    // Fetches without touching the published time; see LocationController.
+    // Canceling the returned future aborts the request.
+    QFuture<TimeReport> requestTime(double lat, double lng);
+    void publishReport(const TimeReport &report);
+    void clearTime();
+
+    // Moves the auto-refresh position and drops replies still in flight
+    // for the previous one.
+    void setPosition(double lat, double lng);
 
 public slots:
     void fetchTimeData(const QString &country);
+    void fetchTimeDataAt(double lat, double lng);
     void startAutoUpdate(int intervalSeconds = 60);
     void stopAutoUpdate();
     void updateLocalTime();
@@ -34,17 +66,27 @@ signals:
     void errorOccurred(const QString &message);
 
 private slots:
-    void handleTimeReply(QNetworkReply *reply);
+    void handleTimeReply(QNetworkReply *reply, double lat, double lng, quint64 generation);
 
 private:
-    QTimer *m_updateTimer;
-    QNetworkAccessManager *m_networkManager;
+    ClockSource *m_clock;
+    ClockTimer *m_updateTimer;
+    NetworkClient *m_network;
     QString m_timeString;
     bool m_loading;
-    QMap<QString, QPair<QString, QString>> m_countryCoordinates;
+    QMap<QString, GeoPoint> m_countryCoordinates;
+    QMap<QString, QString> m_countryCodes;  // ISO 3166-1 alpha-2, as in the city index
+    const CityIndex *m_cityIndex = nullptr;
+    GeoIndex m_geoIndex;
+    QStringList m_geoCountries;     // geo index ids [0, size) are capitals
+    QVector<int> m_geoCityEntries;  // ids past the capitals map to city entries
     QString m_currentCountry;
+    bool m_hasPosition = false;
+    double m_currentLat = 0.0;
+    double m_currentLng = 0.0;
+    quint64 m_positionGeneration = 0;
     int m_timezoneOffsetSec = 0;
-    QTimer *m_localTimeTimer;
+    ClockTimer *m_localTimeTimer;
     QDateTime m_lastSyncedTime;
     QString m_timezone;
 
@@ -53,7 +95,12 @@ private:
     QDateTime m_lastApiTime;
 
     void initializeCountryData();
-    void parseTimeResponse(const QByteArray &data);
+    void addCountry(const QString &name, const QString &code, GeoPoint capital);
+    void rebuildGeoIndex();
+    QVariantMap geoHitToMap(const GeoIndex::Hit &hit) const;
+    QString requestUrl(double lat, double lng) const;
+    void applyReport(const TimeReport &report);
+    static TimeReport parseTimeReport(const QByteArray &data);
 };
 
 #endif // TIMEBACKEND_H
@@ -0,0 +1,99 @@
+#!/usr/bin/env python3
+"""Build the prebuilt city search index loaded by CityIndex.
+
+Input is either a GeoNames dump (cities15000.txt, cities5000.txt, ...; see
+tools/fetch_cities.sh) or the small tab separated seed file in
+data/cities.tsv (name, country, lat, lng, population). The output layout
+must stay in sync with cityindex.cpp:
+
+    header   magic "WCI1", u32 version, u32 count, u32 stringsSize, u32[4] 0
+    entries  count x 28 bytes, sorted by folded key
+             u32 keyOffset, u32 nameOffset, u32 population, f32 lat, f32 lng,
+             u16 keyLen, u16 nameLen, char[2] country, u16 0
+    strings  UTF-8 keys and display names
+
+All integers are little endian.
+
+Usage: build_city_index.py data/cities.tsv data/cities.bin
+"""
+
+import struct
+import sys
+import unicodedata
+
+MAGIC = b"WCI1"
+VERSION = 1
+HEADER = struct.Struct("<4sIII16x")
+ENTRY = struct.Struct("<IIIffHH2sH")
+
+# Letters NFKD does not decompose; must match appendFolded() in cityindex.cpp.
+TRANSLIT = {
+    "ß": "ss", "æ": "ae", "œ": "oe", "ø": "o", "đ": "d", "ð": "d",
+    "ł": "l", "ħ": "h", "ı": "i", "þ": "th",
+}
+
+
+def fold(text):
+    out = []
+    pending_space = False
+    for ch in unicodedata.normalize("NFKD", text):
+        if unicodedata.category(ch).startswith("M"):
+            continue
+        if ch.isalnum():
+            if pending_space and out:
+                out.append(" ")
+            pending_space = False
+            low = ch.lower()
+            out.append(TRANSLIT.get(low, low))
+        else:
+            pending_space = True
+    return "".join(out).encode("utf-8")
+
+
+def read_rows(path):
+    with open(path, encoding="utf-8") as f:
+        for line in f:
+            if not line.strip() or line.startswith("#"):
+                continue
+            cols = line.rstrip("\n").split("\t")
+            if len(cols) >= 19:  # GeoNames: name, lat, lng, country code, population
+                yield cols[1], cols[8], float(cols[4]), float(cols[5]), int(cols[14] or 0)
+            else:
+                yield cols[0], cols[1], float(cols[2]), float(cols[3]), int(cols[4] or 0)
+
+
+def main(src, dst):
+    rows = []
+    for name, country, lat, lng, population in read_rows(src):
+        key = fold(name)
+        if key:
+            rows.append((key, -population, name, country, lat, lng, population))
+    rows.sort()
+
+    strings = bytearray()
+    offsets = {}
+
+    def intern(data):
+        if data not in offsets:
+            offsets[data] = len(strings)
+            strings.extend(data)
+        return offsets[data]
+
+    entries = bytearray()
+    for key, _, name, country, lat, lng, population in rows:
+        name_bytes = name.encode("utf-8")
+        entries += ENTRY.pack(intern(key), intern(name_bytes), min(population, 0xFFFFFFFF),
+                              lat, lng, len(key), len(name_bytes),
+                              country.encode("ascii", "ignore")[:2].ljust(2, b"\0"), 0)
+
+    with open(dst, "wb") as f:
+        f.write(HEADER.pack(MAGIC, VERSION, len(rows), len(strings)))
+        f.write(entries)
+        f.write(strings)
+    print(f"{dst}: {len(rows)} entries, {len(strings)} string bytes")
+
+
+if __name__ == "__main__":
+    if len(sys.argv) != 3:
+        sys.exit(__doc__)
+    main(sys.argv[1], sys.argv[2])
@@ -0,0 +1,17 @@
+#!/bin/sh
+# Rebuild data/cities.bin from a GeoNames dump (default cities15000, every
+# place with a population of at least 15000). The checked-in
+# data/cities.tsv seed is only a fallback for builds without network access
+# and carries no populations, so its results are unranked.
+#
+# Usage: tools/fetch_cities.sh [cities15000|cities5000|cities1000]
+set -e
+
+dump=${1:-cities15000}
+root=$(cd "$(dirname "$0")/.." && pwd)
+tmp=$(mktemp -d)
+trap 'rm -rf "$tmp"' EXIT
+
+curl -fsSL -o "$tmp/$dump.zip" "https://download.geonames.org/export/dump/$dump.zip"
+unzip -q -d "$tmp" "$tmp/$dump.zip"
+python3 "$root/tools/build_city_index.py" "$tmp/$dump.txt" "$root/data/cities.bin"
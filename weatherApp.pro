@@ -3,13 +3,21 @@ QT += quick quickcontrols2
 
 
 SOURCES += \
+        cityindex.cpp \
+        citysearchmodel.cpp \
+        clocksource.cpp \
+        framestats.cpp \
+        geoindex.cpp \
+        locationcontroller.cpp \
         main.cpp \
+        networkclient.cpp \
         timebackend.cpp \
         weatherbackend.cpp
 
 resources.files = main.qml 
 resources.prefix = /$${TARGET}
 RESOURCES += resources \
+    data.qrc \
     flags.qrc \
     img.qrc
 
@@ -26,12 +34,33 @@ else: unix:!android: target.path = /opt/$${TARGET}/bin
 !isEmpty(target.path): INSTALLS += target
 
 HEADERS += \
+    allocprofiler.h \
+    cityindex.h \
+    citysearchmodel.h \
+    clocksource.h \
+    framestats.h \
+    geoindex.h \
+    locationcontroller.h \
+    networkclient.h \
     timebackend.h \
     weatherbackend.h
 
+# Heap profiling build: qmake CONFIG+=alloc_profile
+# Reports allocations per phase on exit and fails when WEATHER_ALLOC_BUDGET
+# is exceeded; WEATHER_ALLOC_PROFILE_SECONDS quits after a fixed run.
+alloc_profile {
+    DEFINES += WEATHER_ALLOC_PROFILE
+    SOURCES += allocprofiler.cpp
+}
+
+include(zlib.pri)
+
 TRANSLATIONS +=
 
-DISTFILES +=
+DISTFILES += \
+    data/cities.tsv \
+    tools/build_city_index.py \
+    tools/fetch_cities.sh
 
 
 
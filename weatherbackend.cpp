@@ -1,8 +1,12 @@
 #include "weatherbackend.h"
+#include "allocprofiler.h"
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QDebug>
+#include <QFutureWatcher>
+#include <QPromise>
 #include <iostream>
+#include <memory>
 
 namespace {
 
@@ -15,7 +19,7 @@ inline const QString &httpsPrefix()
 
 inline const QString &apiBase()
 {
-    static const QString v = QStringLiteral("https://api.weatherapi.com/v1/current.json");
+    static const QString v = qEnvironmentVariable("WEATHER_API_BASE", QStringLiteral("https://api.weatherapi.com/v1/current.json"));
     return v;
 }
 
@@ -92,16 +96,13 @@ inline const QStringList &countriesList()
 
 using namespace std;
 
-WeatherBackend::WeatherBackend(QObject *parent)
+WeatherBackend::WeatherBackend(NetworkClient *network, QObject *parent)
     : QObject(parent)
-    , m_networkManager(new QNetworkAccessManager(this))
+    , m_network(network ? network : new NetworkClient(this))
     , m_loading(false)
 {
     resetData();
 
-    connect(m_networkManager, &QNetworkAccessManager::finished,
-            this, &WeatherBackend::onWeatherReply);
-
     // Initialize with default countries
     m_countries = countriesList();
 }
@@ -111,15 +112,13 @@ void WeatherBackend::resetData()
     m_cityName = placeholder();
     m_temperature = placeholder();
     m_condition = placeholder();
+    m_iconUrl.clear();
+    m_windSpeed.clear();
+    m_humidity.clear();
 }
 
 WeatherBackend::~WeatherBackend()
 {
-    // Clean up network manager
-    if (m_networkManager) {
-        delete m_networkManager;
-        m_networkManager = nullptr;
-    }
 }
 
 QStringList WeatherBackend::countries() const
@@ -174,8 +173,15 @@ void WeatherBackend::setLanguage(const QString &lang)
 }
 
 
+QString WeatherBackend::requestUrl(const QString &location) const
+{
+    return QStringLiteral("%1?key=%2&q=%3&aqi=no&lang=%4")
+        .arg(apiBase(), apiKey(), location, m_language);
+}
+
 void WeatherBackend::fetchWeather(const QString &country)
 {
+    ALLOC_PHASE(RequestBuild);
     cout << country.toStdString() << std::endl;
 
     if (apiKey().isEmpty()) {
@@ -183,10 +189,47 @@ void WeatherBackend::fetchWeather(const QString &country)
         return;
     }
 
-    const QString apiUrl = QStringLiteral("%1?key=%2&q=%3&aqi=no&lang=%4")
-                               .arg(apiBase(), apiKey(), country, m_language);
+    QNetworkReply *reply = m_network->get(QUrl(requestUrl(country)));
+    connect(reply, &QNetworkReply::finished, this, [this, reply]() {
+        onWeatherReply(reply);
+    });
+}
+
+QFuture<WeatherReport> WeatherBackend::requestWeather(const QString &location)
+{
+    ALLOC_PHASE(RequestBuild);
+    auto promise = std::make_shared<QPromise<WeatherReport>>();
+    promise->start();
+    QFuture<WeatherReport> future = promise->future();
+
+    if (apiKey().isEmpty()) {
+        WeatherReport report;
+        report.error = QStringLiteral("Set WEATHER_API_KEY");
+        promise->addResult(report);
+        promise->finish();
+        return future;
+    }
+
+    QNetworkReply *reply = m_network->get(QUrl(requestUrl(location)));
 
-    m_networkManager->get(QNetworkRequest(QUrl(apiUrl)));
+    // Canceling the future aborts the request; the watcher goes with the reply.
+    auto *watcher = new QFutureWatcher<WeatherReport>(reply);
+    connect(watcher, &QFutureWatcherBase::canceled, reply, &QNetworkReply::abort);
+    watcher->setFuture(future);
+
+    connect(reply, &QNetworkReply::finished, this, [reply, promise]() {
+        WeatherReport report;
+        const QString error = NetworkClient::errorString(reply);
+        if (!error.isEmpty())
+            report.error = error;
+        else
+            report = parseWeatherReport(NetworkClient::body(reply));
+        reply->deleteLater();
+
+        promise->addResult(report);
+        promise->finish();
+    });
+    return future;
 }
 
 void WeatherBackend::onWeatherReply(QNetworkReply *reply)
@@ -194,73 +237,107 @@ void WeatherBackend::onWeatherReply(QNetworkReply *reply)
     m_loading = false;
     emit loadingChanged();
 
-    if (reply->error() != QNetworkReply::NoError) {
-        emit errorOccurred(reply->errorString());
+    const QString error = NetworkClient::errorString(reply);
+    if (!error.isEmpty()) {
+        emit errorOccurred(error);
         reply->deleteLater();
         return;
     }
 
-    parseWeatherData(reply->readAll());
+    const WeatherReport report = parseWeatherReport(NetworkClient::body(reply));
     reply->deleteLater();
+
+    if (!report.error.isEmpty())
+        emit errorOccurred(report.error);
+    else
+        applyReport(report, false);
 }
 
-void WeatherBackend::parseWeatherData(const QByteArray &data)
+WeatherReport WeatherBackend::parseWeatherReport(const QByteArray &data)
 {
+    ALLOC_PHASE(Parse);
+    WeatherReport report;
     QJsonParseError parseError;
     QJsonDocument doc = QJsonDocument::fromJson(data, &parseError);
 
     if (parseError.error != QJsonParseError::NoError) {
-        emit errorOccurred("JSON parse error");
-        return;
+        report.error = QStringLiteral("JSON parse error");
+        return report;
     }
 
     QJsonObject json = doc.object();
-    bool hasUpdates = false;
 
     // Extract location
     if (json.contains("location") && json["location"].isObject()) {
         QJsonObject location = json["location"].toObject();
-        if (location.contains("name")) {
-            m_cityName = location["name"].toString();
-            hasUpdates = true;
-        }
+        if (location.contains("name"))
+            report.cityName = location["name"].toString();
     }
 
     // Extract weather data
     if (json.contains("current") && json["current"].isObject()) {
         QJsonObject current = json["current"].toObject();
 
-        if (current.contains("temp_c")) {
-            m_temperature = QString::number(current["temp_c"].toDouble()) + unitTemp();
-            hasUpdates = true;
-        }
+        if (current.contains("temp_c"))
+            report.temperature = QString::number(current["temp_c"].toDouble()) + unitTemp();
 
-        if (current.contains("condition") && json["current"].toObject()["condition"].isObject()) {
+        if (current.contains("condition") && current["condition"].isObject()) {
             QJsonObject condition = current["condition"].toObject();
-            if (condition.contains("text")) {
-                m_condition = condition["text"].toString();
-                hasUpdates = true;
-            }
-
-            if (condition.contains("icon")) {
-                m_iconUrl = httpsPrefix() + condition["icon"].toString();
-                hasUpdates = true;
-            }
-        }
+            if (condition.contains("text"))
+                report.condition = condition["text"].toString();
 
-        if (current.contains("wind_kph")) {
-            m_windSpeed = QString::number(current["wind_kph"].toDouble()) + unitWind();
-            hasUpdates = true;
+            if (condition.contains("icon"))
+                report.iconUrl = httpsPrefix() + condition["icon"].toString();
         }
 
-        if (current.contains("humidity")) {
-            m_humidity = QString::number(current["humidity"].toInt()) + unitHumidity();
-            hasUpdates = true;
-        }
+        if (current.contains("wind_kph"))
+            report.windSpeed = QString::number(current["wind_kph"].toDouble()) + unitWind();
+
+        if (current.contains("humidity"))
+            report.humidity = QString::number(current["humidity"].toInt()) + unitHumidity();
     }
 
-    if (hasUpdates)
+    return report;
+}
+
+void WeatherBackend::publishReport(const WeatherReport &report)
+{
+    applyReport(report, true);
+}
+
+// A refresh of the same location only overwrites the fields it carries.
+// replace resets everything first, so a new location never keeps the
+// previous one's icon, wind or humidity.
+void WeatherBackend::applyReport(const WeatherReport &report, bool replace)
+{
+    if (replace)
+        resetData();
+
+    bool hasUpdates = replace;
+    const auto take = [&hasUpdates](QString &field, const QString &value) {
+        if (value.isNull())
+            return;
+        field = value;
+        hasUpdates = true;
+    };
+
+    take(m_cityName, report.cityName);
+    take(m_temperature, report.temperature);
+    take(m_condition, report.condition);
+    take(m_iconUrl, report.iconUrl);
+    take(m_windSpeed, report.windSpeed);
+    take(m_humidity, report.humidity);
+
+    if (hasUpdates) {
+        ALLOC_PHASE(Publish);
         emit weatherUpdated();
+    }
+}
+
+void WeatherBackend::clearWeather()
+{
+    resetData();
+    emit weatherUpdated();
 }
 
 void WeatherBackend::loadCountries()
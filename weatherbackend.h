@@ -2,9 +2,23 @@
 #define WEATHERBACKEND_H
 
 #include <QObject>
-#include <QNetworkAccessManager>
+#include <QFuture>
 #include <QNetworkReply>
 #include <QStringList>
+#include "networkclient.h"
+
+// One parsed weather response. Fields absent from the response stay null;
+// error is set when the request or the parse failed.
+struct WeatherReport
+{
+    QString cityName;
+    QString temperature;
+    QString condition;
+    QString iconUrl;
+    QString windSpeed;
+    QString humidity;
+    QString error;
+};
 
 class WeatherBackend : public QObject
 {
@@ -20,7 +34,7 @@ class WeatherBackend : public QObject
     Q_PROPERTY(QString language READ language WRITE setLanguage NOTIFY languageChanged)
 
 public:
-    explicit WeatherBackend(QObject *parent = nullptr);
+    explicit WeatherBackend(NetworkClient *network = nullptr, QObject *parent = nullptr);
     ~WeatherBackend();
 
     QStringList countries() const;
@@ -35,6 +49,12 @@ public:
     QString language() const;
     Q_INVOKABLE void setLanguage(const QString &lang);
 
+    // Fetches without touching the published properties; see LocationController.
+    // Canceling the returned future aborts the request.
+    QFuture<WeatherReport> requestWeather(const QString &location);
+    void publishReport(const WeatherReport &report);
+    void clearWeather();
+
 public slots:
     void fetchWeather(const QString &location);
     void loadCountries();
@@ -51,7 +71,7 @@ private slots:
     void onWeatherReply(QNetworkReply *reply);
 
 private:
-    QNetworkAccessManager *m_networkManager;
+    NetworkClient *m_network;
     QStringList m_countries;
     QString m_cityName;
     QString m_temperature;
@@ -65,7 +85,9 @@ private:
 
 
 
-    void parseWeatherData(const QByteArray &data);
+    QString requestUrl(const QString &location) const;
+    static WeatherReport parseWeatherReport(const QByteArray &data);
+    void applyReport(const WeatherReport &report, bool replace);
     void resetData();
 };
 
@@ -0,0 +1,20 @@
+# NetworkClient decodes gzip itself so it can count compressed bytes; use
+# the zlib Qt was built with, system or bundled. Sources include
+# zlibsupport.h, which picks the matching header.
+qtConfig(system-zlib) {
+    LIBS += -lz
+} else {
+    QT += zlib-private
+    DEFINES += WEATHER_QT_ZLIB
+}
+
+# Brotli is optional: NetworkClient only offers "br" when libbrotlidec is
+# found through pkg-config, and servers fall back to gzip otherwise.
+packagesExist(libbrotlidec) {
+    CONFIG += link_pkgconfig
+    PKGCONFIG += libbrotlidec
+    DEFINES += WEATHER_BROTLI
+}
+
+INCLUDEPATH += $$PWD
+HEADERS += $$PWD/zlibsupport.h
@@ -0,0 +1,12 @@
+#ifndef ZLIBSUPPORT_H
+#define ZLIBSUPPORT_H
+
+// The zlib Qt was built with; zlib.pri sets WEATHER_QT_ZLIB when that is
+// Qt's bundled copy rather than the system library.
+#ifdef WEATHER_QT_ZLIB
+#include <QtZlib/zlib.h>
+#else
+#include <zlib.h>
+#endif
+
+#endif // ZLIBSUPPORT_H